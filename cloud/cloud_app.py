@@ -18,6 +18,11 @@ from datetime import datetime, timedelta
 
 import mysql.connector
 
+try:
+    import cbor2
+except ImportError:
+    cbor2 = None
+
 from modules.db_manager import HVAC_DB
 from modules.mqtt_manager import get_mqtt_client
 import config.app_config as conf
@@ -119,91 +124,141 @@ def remote_control_logic(component):
         elif hvac_status not in [0,4] and hvac_mode == 0: # hvac on and normal mode
             normal_feedback_logic()
 
+# SenML labels used by the nodes (common/senml-cbor.h)
+SENML_BASE_NAME = -2
+SENML_NAME = 0
+SENML_VALUE = 2
+
+def senml_to_dict(pack):
+    # [{bn:"weather/",n:"irr",v:..},{n:"outTemp",v:..}] -> {"n":"weather","irr":..,"outTemp":..}
+    # [{bn:"battery",v:..}] -> {"n":"battery","v":..}
+    payload = {}
+    base_name = ""
+    for record in pack:
+        base_name = record.get(SENML_BASE_NAME, base_name)
+        if SENML_VALUE not in record:
+            continue
+        name = record.get(SENML_NAME)
+        payload["n"] = base_name.rstrip("/")
+        payload[name if name else "v"] = record[SENML_VALUE]
+    return payload
+
+def senml_split(pack):
+    # records of different base names: composite resources like /sensors/all
+    packs = []
+    for record in pack:
+        if SENML_BASE_NAME in record or not packs:
+            packs.append([])
+        packs[-1].append(record)
+    return packs
+
+def decode_payload(response):
+    # JSON by default, SenML-CBOR if an observer asked for it
+    if response.content_type == conf.SENML_CBOR_CONTENT_FORMAT:
+        if cbor2 is None:
+            raise ValueError("SenML-CBOR payload received but cbor2 is not installed")
+        packs = senml_split(cbor2.loads(response.payload))
+        payload = senml_to_dict(packs[0])
+        if payload.get("n") == "all":
+            # {"n":"all","ch":..} then one pack per field, as in the JSON
+            payload = {"n": "all", "ch": payload.get("ch", 0), "d": [senml_to_dict(p) for p in packs[1:]]}
+        return payload
+    payload_raw = response.payload.decode('utf-8') if isinstance(response.payload, bytes) else response.payload
+    return json.loads(payload_raw)
+
 def notification_callback(url, response):
     if response is None:
         print(f"No response received for {url}")
         return
     global last_response
     last_response[url] = response
-    payload_raw = None
     try:
         global mq_client
-        payload_raw = response.payload.decode('utf-8') if isinstance(response.payload, bytes) else response.payload
-        if not payload_raw:
+        if not response.payload:
             print(f"Empty payload received from {url}. Skipping processing.")
             return
-        payload = json.loads(payload_raw)
-        data_type = payload.get("n") # Determine the actual type of data based on the 'n' field in the payload
-        if not data_type:
-            raise ValueError("Payload missing 'n' field (data type identifier). Cannot process.")
-
-        if data_type == "weather":
-            # Process weather data: "{\"n\":\"weather\",\"irr\":%s,\"outTemp\":%s,\"modTemp\":%s}"
-            if "n" in payload and payload["n"] == "weather" \
-                and "irr" in payload and "outTemp" in payload and "modTemp" in payload:
-                for key in ["irr", "outTemp", "modTemp"]:
-                    if not isinstance(payload[key], (int, float)):
-                        raise ValueError(f"Invalid value for {key}: {payload[key]}")
-                    HVAC_DB.insert_sensor_data(key, payload[key])
-            else:
-                raise ValueError("Invalid weather data format")
-            remote_control_logic(data_type)
-        elif data_type in ["battery", "gen_power", "roomTemp"]:
-            # Process other sensor data
-            if "n" in payload and payload["n"] == data_type and "v" in payload:
-                HVAC_DB.insert_sensor_data(data_type, payload["v"])
-            else:
-                raise ValueError(f"Invalid data format for {data_type}")
-            remote_control_logic(data_type)       
-        elif data_type == "relay":
-            # Process relay data: "{\"n\":\"relay\",\"r_sp\":%d,\"r_h\":%d,\"p_sp\":%s,\"p_h\":%s}"
-            if "n" in payload and payload["n"] == "relay" \
-                and "r_sp" in payload and "r_h" in payload \
-                and "p_sp" in payload and "p_h" in payload:
-                HVAC_DB.insert_relay_data(
-                    payload["r_sp"], 
-                    payload["r_h"], 
-                    payload["p_sp"], 
-                    payload["p_h"]
-                )
-            else:
-                raise ValueError("Invalid relay data format")  
-            # nothing to control      
-        elif data_type == "antiDust":
-            # Process anti-dust data: "{\"n\":\"antiDust\",\"v\":%d}",
-            if "n" in payload and payload["n"] == "antiDust" and "v" in payload:
-                HVAC_DB.insert_anti_dust_data(payload["v"])
-                mq_client.publish("antiDust", payload["v"])
-            else:
-                raise ValueError("Invalid anti-dust data format")
-        elif data_type == "settings":
-            # Process HVAC data: "{\"n\":\"settings\",\"pw\":%s,\"status\":%d,\"mode\":%d,\"targetTemp\":%s}",
-            if "n" in payload and payload["n"] == "settings" \
-                and "pw" in payload and "status" in payload \
-                and "mode" in payload and "targetTemp" in payload:
-                HVAC_DB.insert_hvac_data(
-                    payload["pw"], 
-                    payload["status"], 
-                    payload["mode"], 
-                    payload["targetTemp"]
-                )
-                if payload["status"] == 4:
-                    mq_client.publish("hvac", "error")
-            else:
-                raise ValueError("Invalid HVAC data format")
-            remote_control_logic("settings")
+        payload = decode_payload(response)
+        if payload.get("n") == "all":
+            # composite of the energy node resources, "ch": fields changed
+            for field_payload in payload.get("d", []):
+                process_payload(url, field_payload)
         else:
-            raise ValueError(f"Unknown URL: {url}")
+            process_payload(url, payload)
     except mysql.connector.Error as e:
         print(f"Database error: {e}")        
     except Exception as e:
         print(f"Error processing notification: {url}, {e}")
 
+def process_payload(url, payload):
+    data_type = payload.get("n") # Determine the actual type of data based on the 'n' field in the payload
+    if not data_type:
+        raise ValueError("Payload missing 'n' field (data type identifier). Cannot process.")
+
+    if data_type == "weather":
+        # Process weather data: "{\"n\":\"weather\",\"irr\":%s,\"outTemp\":%s,\"modTemp\":%s}"
+        if "n" in payload and payload["n"] == "weather" \
+            and "irr" in payload and "outTemp" in payload and "modTemp" in payload:
+            for key in ["irr", "outTemp", "modTemp"]:
+                if not isinstance(payload[key], (int, float)):
+                    raise ValueError(f"Invalid value for {key}: {payload[key]}")
+                HVAC_DB.insert_sensor_data(key, payload[key])
+        else:
+            raise ValueError("Invalid weather data format")
+        remote_control_logic(data_type)
+    elif data_type in ["battery", "gen_power", "roomTemp"]:
+        # Process other sensor data
+        if "n" in payload and payload["n"] == data_type and "v" in payload:
+            HVAC_DB.insert_sensor_data(data_type, payload["v"])
+        else:
+            raise ValueError(f"Invalid data format for {data_type}")
+        remote_control_logic(data_type)       
+    elif data_type == "relay":
+        # Process relay data: "{\"n\":\"relay\",\"r_sp\":%d,\"r_h\":%d,\"p_sp\":%s,\"p_h\":%s}"
+        if "n" in payload and payload["n"] == "relay" \
+            and "r_sp" in payload and "r_h" in payload \
+            and "p_sp" in payload and "p_h" in payload:
+            HVAC_DB.insert_relay_data(
+                payload["r_sp"], 
+                payload["r_h"], 
+                payload["p_sp"], 
+                payload["p_h"]
+            )
+        else:
+            raise ValueError("Invalid relay data format")  
+        # nothing to control      
+    elif data_type == "antiDust":
+        # Process anti-dust data: "{\"n\":\"antiDust\",\"v\":%d}",
+        if "n" in payload and payload["n"] == "antiDust" and "v" in payload:
+            HVAC_DB.insert_anti_dust_data(payload["v"])
+            mq_client.publish("antiDust", payload["v"])
+        else:
+            raise ValueError("Invalid anti-dust data format")
+    elif data_type == "settings":
+        # Process HVAC data: "{\"n\":\"settings\",\"pw\":%s,\"status\":%d,\"mode\":%d,\"targetTemp\":%s}",
+        if "n" in payload and payload["n"] == "settings" \
+            and "pw" in payload and "status" in payload \
+            and "mode" in payload and "targetTemp" in payload:
+            HVAC_DB.insert_hvac_data(
+                payload["pw"], 
+                payload["status"], 
+                payload["mode"], 
+                payload["targetTemp"]
+            )
+            if payload["status"] == 4:
+                mq_client.publish("hvac", "error")
+        else:
+            raise ValueError("Invalid HVAC data format")
+        remote_control_logic("settings")
+    else:
+        raise ValueError(f"Unknown URL: {url}")
+
 def start_observation(client, url):
     try:
+        options = {"accept": conf.SENML_CBOR_CONTENT_FORMAT} if conf.COAP_SENML_CBOR else {}
         client.observe(
             url, 
-            callback=lambda resp: notification_callback(url, resp))
+            callback=lambda resp: notification_callback(url, resp),
+            **options)
         print(f"Started observation on {url}")
     except Exception as e:
         print(f"Error starting observation on {url}: {e}")
@@ -219,22 +274,29 @@ def stop_observation(client, url):
 
 def start_all_observations():
     print("Starting observations for all sensors...")
-    start_observation(client_energy_WEATHER, conf.WEATHER_URL)
-    start_observation(client_energy_BATTERY, conf.BATTERY_URL)
-    start_observation(client_energy_GEN_POWER, conf.GEN_POWER_URL)
-    start_observation(client_energy_RELAY, conf.RELAY_URL)
-    start_observation(client_energy_ANTI_DUST, conf.ANTI_DUST_URL)
+    if conf.COAP_SENSORS_ALL:
+        # one observation for all the energy node resources
+        start_observation(client_energy_WEATHER, conf.SENSORS_ALL_URL)
+    else:
+        start_observation(client_energy_WEATHER, conf.WEATHER_URL)
+        start_observation(client_energy_BATTERY, conf.BATTERY_URL)
+        start_observation(client_energy_GEN_POWER, conf.GEN_POWER_URL)
+        start_observation(client_energy_RELAY, conf.RELAY_URL)
+        start_observation(client_energy_ANTI_DUST, conf.ANTI_DUST_URL)
     start_observation(client_hvac_ROOM_TEMP, conf.ROOM_TEMP_URL)
     start_observation(client_hvac_SETTINGS, conf.SETTINGS_URL)
     print("All observations started successfully.")
 
 def stop_all_observations():
     print("Stopping observations for all sensors...")
-    stop_observation(client_energy_WEATHER, conf.WEATHER_URL)
-    stop_observation(client_energy_BATTERY, conf.BATTERY_URL)
-    stop_observation(client_energy_GEN_POWER, conf.GEN_POWER_URL)
-    stop_observation(client_energy_RELAY, conf.RELAY_URL)
-    stop_observation(client_energy_ANTI_DUST, conf.ANTI_DUST_URL)
+    if conf.COAP_SENSORS_ALL:
+        stop_observation(client_energy_WEATHER, conf.SENSORS_ALL_URL)
+    else:
+        stop_observation(client_energy_WEATHER, conf.WEATHER_URL)
+        stop_observation(client_energy_BATTERY, conf.BATTERY_URL)
+        stop_observation(client_energy_GEN_POWER, conf.GEN_POWER_URL)
+        stop_observation(client_energy_RELAY, conf.RELAY_URL)
+        stop_observation(client_energy_ANTI_DUST, conf.ANTI_DUST_URL)
     stop_observation(client_hvac_ROOM_TEMP, conf.ROOM_TEMP_URL)
     stop_observation(client_hvac_SETTINGS, conf.SETTINGS_URL)
     print("All observations stopped successfully.")
@@ -272,7 +334,7 @@ def get_v(key):
             "antiDust": conf.ANTI_DUST_URL
         }
         response = client_energy.get(url_map[key]) if key != "roomTemp" else client_hvac.get(url_map[key])
-        data = json.loads(response.payload) if response.payload is not None else {"v": data[1]}
+        data = decode_payload(response) if response.payload is not None else {"v": data[1]}
         return data
     return {"v": data[2]} if key != "antiDust" else {"v": data[1]}
 
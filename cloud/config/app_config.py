@@ -16,10 +16,19 @@ BATTERY_URL = '/sensors/battery'
 GEN_POWER_URL = '/sensors/power'
 RELAY_URL = '/relay'
 ANTI_DUST_URL = '/antiDust'
+# Composite of the energy node resources, f= selects a subset of them
+SENSORS_ALL_URL = '/sensors/all'
 
 ROOM_TEMP_URL = '/sensors/roomTemp'
 SETTINGS_URL = '/settings'
 
+# Ask the nodes for SenML-CBOR notifications instead of JSON (needs cbor2)
+COAP_SENML_CBOR = False
+SENML_CBOR_CONTENT_FORMAT = 112
+
+# Observe /sensors/all instead of the five energy node resources
+COAP_SENSORS_ALL = False
+
 # DB CONFIG
 DB_HOST = 'localhost'
 DB_USER = 'root'
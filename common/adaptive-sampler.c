@@ -0,0 +1,52 @@
+#include <math.h>
+#include "adaptive-sampler.h"
+#include "fixed-fmt.h"
+
+clock_time_t adaptive_sampler_update(adaptive_sampler_t *sampler, float value, float distance)
+{
+    clock_time_t now = clock_time();
+
+    if (!sampler->started) {
+        // no rate yet: sample again soon
+        sampler->started = true;
+        sampler->last = value;
+        sampler->last_time = now;
+        sampler->interval = sampler->min_interval;
+        return sampler->interval;
+    }
+
+    float seconds = (float) (now - sampler->last_time) / CLOCK_SECOND;
+    if (seconds > 0.0f) {
+        float rate = (value - sampler->last) / seconds;
+        float diff = rate - sampler->mean;
+        sampler->mean += ADAPTIVE_SAMPLER_ALPHA * diff;
+        sampler->var = (1.0f - ADAPTIVE_SAMPLER_ALPHA) * (sampler->var + ADAPTIVE_SAMPLER_ALPHA * diff * diff);
+        sampler->last = value;
+        sampler->last_time = now;
+    }
+
+    float step = sampler->step;
+    if (distance >= 0.0f && distance < step)
+        step = distance;
+
+    float activity = fabsf(sampler->mean) + sqrtf(sampler->var);
+    float interval = (float) sampler->max_interval;
+    if (activity > 0.0f && step / activity * CLOCK_SECOND < interval)
+        interval = step / activity * CLOCK_SECOND;
+
+    sampler->interval = interval < sampler->min_interval ? sampler->min_interval : (clock_time_t) interval;
+    return sampler->interval;
+}
+
+char *adaptive_sampler_json(char *out, const char *name, const adaptive_sampler_t *sampler)
+{
+    out = fmt_str(out, "\"");
+    out = fmt_str(out, name);
+    out = fmt_str(out, "\":[");
+    out = fmt_fixed(out, (float) sampler->interval / CLOCK_SECOND, 1);
+    out = fmt_str(out, ",");
+    out = fmt_fixed(out, sampler->mean, 4);
+    out = fmt_str(out, ",");
+    out = fmt_fixed(out, sqrtf(sampler->var), 4);
+    return fmt_str(out, "]");
+}
@@ -0,0 +1,46 @@
+#ifndef ADAPTIVE_SAMPLER_H_
+#define ADAPTIVE_SAMPLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "contiki.h"
+
+// Sampling interval of a signal from how fast it moves.
+// The rate of change between samples goes into an EWMA mean and
+// variance: the next sample is due when the signal is expected to have
+// moved by step (|mean| + standard deviation of the rate), or to have
+// reached a control boundary if that is closer, within
+// [min_interval, max_interval]. Steady signals are sampled at
+// max_interval, transients at min_interval. The bounds are parameters of
+// the node configuration, see node-config.h.
+
+#ifdef ADAPTIVE_SAMPLER_CONF_ALPHA
+#define ADAPTIVE_SAMPLER_ALPHA ADAPTIVE_SAMPLER_CONF_ALPHA
+#else
+#define ADAPTIVE_SAMPLER_ALPHA 0.25f // weight of the last rate
+#endif
+
+#define ADAPTIVE_SAMPLER_NO_BOUNDARY (-1.0f)
+
+typedef struct {
+    float step; // change worth a sample
+    clock_time_t min_interval;
+    clock_time_t max_interval;
+    // state
+    bool started;
+    float last;
+    clock_time_t last_time;
+    float mean; // rate of change, per second
+    float var;
+    clock_time_t interval;
+} adaptive_sampler_t;
+
+// Adds a sample of the signal, distance is how far it is from a control
+// boundary (ADAPTIVE_SAMPLER_NO_BOUNDARY: none). Returns the interval to
+// the next sample.
+clock_time_t adaptive_sampler_update(adaptive_sampler_t *sampler, float value, float distance);
+
+// "<name>":[interval,mean,sd] into out, returns the end
+char *adaptive_sampler_json(char *out, const char *name, const adaptive_sampler_t *sampler);
+
+#endif /* ADAPTIVE_SAMPLER_H_ */
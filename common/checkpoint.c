@@ -0,0 +1,235 @@
+#include <string.h>
+#include "checkpoint.h"
+#include "cfs/cfs.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "CKPT"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// Log: header ('C', 'K', format, generation) then records
+// (id, version, length, data, CRC-16 of the previous fields)
+#define CHECKPOINT_FORMAT 1
+#define HEADER_SIZE 5
+#define RECORD_OVERHEAD 5
+
+static const char *const files[2] = { "ckpt.0", "ckpt.1" };
+
+static checkpoint_item_t *const *items = NULL;
+static uint8_t current = 0;  // file of the log
+static uint16_t generation = 0;
+static uint16_t log_size = 0;
+
+// CRC-16/CCITT-FALSE
+static uint16_t crc16(uint16_t crc, const uint8_t *data, uint8_t len)
+{
+    while (len--) {
+        crc ^= (uint16_t) *data++ << 8;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// Record of the current data of item into out, returns its size
+static uint8_t pack_record(const checkpoint_item_t *item, uint8_t *out)
+{
+    uint8_t len = 0;
+
+    for (uint8_t i = 0; i < CHECKPOINT_MAX_PARTS && item->parts[i].data != NULL; i++) {
+        memcpy(out + 3 + len, item->parts[i].data, item->parts[i].size);
+        len += item->parts[i].size;
+    }
+    out[0] = item->id;
+    out[1] = item->version;
+    out[2] = len;
+
+    uint16_t crc = crc16(0xffff, out, 3 + len);
+    out[3 + len] = crc & 0xff;
+    out[4 + len] = crc >> 8;
+    return len + RECORD_OVERHEAD;
+}
+
+static uint16_t record_crc(const uint8_t *record, uint8_t size)
+{
+    return record[size - 2] | (uint16_t) record[size - 1] << 8;
+}
+
+static bool write_record(int fd, const uint8_t *record, uint8_t size)
+{
+    if (cfs_write(fd, record, size) != size)
+        return false;
+    log_size += size;
+    return true;
+}
+
+// record of item is in the log
+static void mark_saved(checkpoint_item_t *item, const uint8_t *record, uint8_t size)
+{
+    item->crc = record_crc(record, size);
+    item->last_write = clock_time();
+    item->dirty = false;
+}
+
+// Current state of all the items into the other file, then it becomes
+// the log. The items are saved only once all of them are written: after a
+// failure they keep the CRC of their record in the old log, still the log.
+static bool compact(void)
+{
+    uint8_t next = !current;
+    uint8_t header[HEADER_SIZE] = { 'C', 'K', CHECKPOINT_FORMAT, (generation + 1) & 0xff, (generation + 1) >> 8 };
+    uint8_t record[CHECKPOINT_MAX_DATA + RECORD_OVERHEAD];
+    bool ok;
+
+    cfs_remove(files[next]);
+    int fd = cfs_open(files[next], CFS_WRITE);
+    if (fd < 0)
+        return false;
+
+    uint16_t old_size = log_size;
+    log_size = HEADER_SIZE;
+    ok = cfs_write(fd, header, HEADER_SIZE) == HEADER_SIZE;
+    for (uint8_t i = 0; ok && items[i] != NULL; i++)
+        ok = write_record(fd, record, pack_record(items[i], record));
+    cfs_close(fd);
+
+    if (!ok) {
+        LOG_WARN("Checkpoint compaction failed\n");
+        cfs_remove(files[next]);
+        log_size = old_size;
+        return false;
+    }
+
+    cfs_remove(files[current]);
+    current = next;
+    generation++;
+    // the data did not change since, the handlers do not run in between
+    for (uint8_t i = 0; items[i] != NULL; i++)
+        mark_saved(items[i], record, pack_record(items[i], record));
+    return true;
+}
+
+static bool append(checkpoint_item_t *item)
+{
+    uint8_t record[CHECKPOINT_MAX_DATA + RECORD_OVERHEAD];
+    uint8_t size = pack_record(item, record);
+
+    if (log_size + size > CHECKPOINT_LOG_SIZE)
+        return compact();
+
+    int fd = cfs_open(files[current], CFS_WRITE | CFS_APPEND);
+    if (fd < 0)
+        return false;
+    bool ok = write_record(fd, record, size);
+    cfs_close(fd);
+    if (ok)
+        mark_saved(item, record, size);
+    return ok;
+}
+
+static bool read_header(uint8_t file, uint16_t *gen)
+{
+    uint8_t header[HEADER_SIZE];
+    int fd = cfs_open(files[file], CFS_READ);
+
+    if (fd < 0)
+        return false;
+    int len = cfs_read(fd, header, HEADER_SIZE);
+    cfs_close(fd);
+
+    if (len != HEADER_SIZE || header[0] != 'C' || header[1] != 'K' || header[2] != CHECKPOINT_FORMAT)
+        return false;
+    *gen = header[3] | (uint16_t) header[4] << 8;
+    return true;
+}
+
+// Restores the records of file up to the first torn or corrupted one,
+// returns the items restored
+static uint32_t replay(uint8_t file)
+{
+    uint8_t record[CHECKPOINT_MAX_DATA + RECORD_OVERHEAD];
+    uint32_t restored = 0;
+    int fd = cfs_open(files[file], CFS_READ);
+
+    if (fd < 0)
+        return 0;
+    cfs_seek(fd, HEADER_SIZE, CFS_SEEK_SET);
+
+    while (cfs_read(fd, record, 3) == 3 && record[2] <= CHECKPOINT_MAX_DATA) {
+        uint8_t size = record[2] + RECORD_OVERHEAD;
+        if (cfs_read(fd, record + 3, size - 3) != size - 3
+            || crc16(0xffff, record, size - 2) != record_crc(record, size))
+            break;
+
+        for (uint8_t i = 0; items[i] != NULL; i++) {
+            checkpoint_item_t *item = items[i];
+            uint8_t expected[CHECKPOINT_MAX_DATA + RECORD_OVERHEAD];
+            if (item->id != record[0])
+                continue;
+            // same layout: version and size
+            if (item->version == record[1] && pack_record(item, expected) == size) {
+                const uint8_t *data = record + 3;
+                for (uint8_t p = 0; p < CHECKPOINT_MAX_PARTS && item->parts[p].data != NULL; p++) {
+                    memcpy(item->parts[p].data, data, item->parts[p].size);
+                    data += item->parts[p].size;
+                }
+                restored |= (uint32_t) 1 << i;
+            }
+            break;
+        }
+    }
+    cfs_close(fd);
+    return restored;
+}
+
+uint8_t checkpoint_restore(checkpoint_item_t *const *checkpoint_items)
+{
+    uint16_t gen[2];
+    bool valid[2];
+    uint32_t restored = 0;
+    uint8_t n = 0;
+
+    items = checkpoint_items;
+    valid[0] = read_header(0, &gen[0]);
+    valid[1] = read_header(1, &gen[1]);
+
+    // both only if a compaction was interrupted: the newer one last
+    if (valid[0] && valid[1]) {
+        current = (int16_t) (gen[1] - gen[0]) > 0 ? 1 : 0;
+        restored = replay(!current) | replay(current);
+    } else if (valid[0] || valid[1]) {
+        current = valid[0] ? 0 : 1;
+        restored = replay(current);
+    }
+    generation = valid[current] ? gen[current] : 0;
+
+    for (uint8_t i = 0; items[i] != NULL; i++)
+        if (restored & ((uint32_t) 1 << i))
+            n++;
+    LOG_INFO("Checkpoint generation %u: %u items restored\n", generation, n);
+
+    // a fresh log with the restored state
+    compact();
+    return n;
+}
+
+void checkpoint_save(checkpoint_item_t *item)
+{
+    uint8_t record[CHECKPOINT_MAX_DATA + RECORD_OVERHEAD];
+    clock_time_t now = clock_time();
+
+    if (items == NULL)
+        return; // before the restore
+
+    uint8_t size = pack_record(item, record);
+    if (record_crc(record, size) == item->crc) {
+        item->dirty = false; // back to the saved value
+        return;
+    }
+    item->dirty = true;
+
+    for (uint8_t i = 0; items[i] != NULL; i++) {
+        checkpoint_item_t *it = items[i];
+        if (it->dirty && now - it->last_write >= it->min_period && !append(it))
+            LOG_WARN("Checkpoint of item %u failed\n", it->id);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "contiki.h"
+
+// Node state kept across reboots in a CFS log.
+// Each change of a state item appends a record (id, version, data, CRC)
+// to the log; at boot the log is replayed and the last valid record of
+// each item is restored. When the log is full the current state is
+// written to a new log, alternating between two files with increasing
+// generations, and the old one is removed: a reset at any time leaves a
+// complete log. Records of an item whose version changed are ignored, the
+// item keeps its default.
+
+#ifdef CHECKPOINT_CONF_LOG_SIZE
+#define CHECKPOINT_LOG_SIZE CHECKPOINT_CONF_LOG_SIZE
+#else
+#define CHECKPOINT_LOG_SIZE 512 // bytes, then the log is compacted
+#endif
+
+#define CHECKPOINT_MAX_PARTS 4
+#define CHECKPOINT_MAX_DATA 32 // bytes of the parts of an item
+
+typedef struct {
+    uint8_t id;      // unique on the node
+    uint8_t version; // of the parts layout
+    clock_time_t min_period; // between records of continuous values, 0: every change
+    struct {
+        void *data;
+        uint8_t size;
+    } parts[CHECKPOINT_MAX_PARTS]; // NULL terminated if less
+    // state
+    uint16_t crc; // of the last record
+    clock_time_t last_write;
+    bool dirty;
+} checkpoint_item_t;
+
+// Replays the log into items (NULL terminated) and starts a new one.
+// Returns the number of items restored.
+uint8_t checkpoint_restore(checkpoint_item_t *const *items);
+
+// The item changed: appends a record, unless the data is the same as the
+// last one or min_period has not elapsed (then the record is written by
+// a later call, of any item)
+void checkpoint_save(checkpoint_item_t *item);
+
+#endif /* CHECKPOINT_H_ */
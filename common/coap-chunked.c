@@ -0,0 +1,69 @@
+#include <string.h>
+#include "coap-chunked.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+void coap_chunked_write(coap_chunked_t *out, const void *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        out->hash = (out->hash ^ ((const uint8_t *) data)[i]) * FNV_PRIME;
+
+    int32_t from = out->start - out->pos;
+    int32_t to = out->start + out->size - out->pos;
+
+    if (from < 0)
+        from = 0;
+    if (to > (int32_t) len)
+        to = len;
+    if (from < to)
+        memcpy(out->buffer + out->pos + from - out->start, (const uint8_t *) data + from, to - from);
+    out->pos += len;
+}
+
+void coap_chunked_put(coap_chunked_t *out, const char *s)
+{
+    coap_chunked_write(out, s, strlen(s));
+}
+
+bool coap_chunked_full(const coap_chunked_t *out)
+{
+    return out->pos > out->start + out->size;
+}
+
+void coap_chunked_respond(coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset,
+                          unsigned int content_format, coap_chunked_generator_t generator, void *data)
+{
+    coap_chunked_t out = { buffer, offset != NULL ? *offset : 0, preferred_size, 0, FNV_OFFSET_BASIS };
+
+    generator(&out, data);
+
+    if (out.pos <= out.start && out.start > 0) {
+        coap_set_status_code(response, BAD_OPTION_4_02);
+        const char *error_msg = "BlockOutOfScope";
+        coap_set_payload(response, error_msg, strlen(error_msg));
+        return;
+    }
+
+    int32_t len = out.pos - out.start < out.size ? out.pos - out.start : out.size;
+    coap_set_header_content_format(response, content_format);
+    coap_set_payload(response, buffer, len);
+    coap_chunked_set_etag(response, out.hash);
+
+    if (offset == NULL)
+        return;
+    *offset += len;
+    if (*offset >= out.pos)
+        *offset = -1;
+}
+
+void coap_chunked_set_etag(coap_message_t *response, uint32_t revision)
+{
+    uint8_t etag[4] = { revision, revision >> 8, revision >> 16, revision >> 24 };
+    coap_set_header_etag(response, etag, sizeof(etag));
+}
+
+void coap_chunked_set_period_etag(coap_message_t *response)
+{
+    coap_chunked_set_etag(response, clock_seconds() / COAP_CHUNKED_ETAG_PERIOD);
+}
@@ -0,0 +1,61 @@
+#ifndef COAP_CHUNKED_H_
+#define COAP_CHUNKED_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "contiki.h"
+#include "coap-engine.h"
+
+// Block2 responses generated on the fly.
+// A generator writes the whole representation from the start through the
+// coap_chunked_* writers at each block request: only the bytes of the
+// requested block are copied to the CoAP buffer, so the full body is
+// never held in RAM. The representation has to be the same across the
+// blocks of a transfer: each block carries an ETag, by default a hash of
+// the whole representation, so that a client sees when it changed between
+// two blocks and starts over.
+
+// Period of the ETag of coap_chunked_set_period_etag(), in seconds
+#ifdef COAP_CHUNKED_CONF_ETAG_PERIOD
+#define COAP_CHUNKED_ETAG_PERIOD COAP_CHUNKED_CONF_ETAG_PERIOD
+#else
+#define COAP_CHUNKED_ETAG_PERIOD 10
+#endif
+
+typedef struct {
+    uint8_t *buffer;
+    int32_t start; // offset of the block in the representation
+    int32_t size;  // block size
+    int32_t pos;   // bytes generated so far
+    uint32_t hash; // FNV-1a of the bytes generated
+} coap_chunked_t;
+
+typedef void (*coap_chunked_generator_t)(coap_chunked_t *out, void *data);
+
+void coap_chunked_write(coap_chunked_t *out, const void *data, size_t len);
+void coap_chunked_put(coap_chunked_t *out, const char *s);
+
+// True once the block is complete and something follows it: generators
+// with many items can stop there
+bool coap_chunked_full(const coap_chunked_t *out);
+
+// Runs generator for the block at *offset (the first one for
+// notifications) and sets the payload, the content format, the ETag and
+// the next offset, -1 after the last block. Replies 4.02 if the offset is
+// past the end of the representation.
+void coap_chunked_respond(coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset,
+                          unsigned int content_format, coap_chunked_generator_t generator, void *data);
+
+// Replaces the ETag of coap_chunked_respond() by revision, for generators
+// that stop at the block (then the hash does not cover the whole
+// representation) or whose representation changes at every request
+void coap_chunked_set_etag(coap_message_t *response, uint32_t revision);
+
+// Replaces the ETag by the uptime period, for live counters, some of them
+// moved by the GET itself: a hash would change at every block. The blocks
+// of a transfer come from the same COAP_CHUNKED_ETAG_PERIOD, a transfer
+// across a period boundary starts over.
+void coap_chunked_set_period_etag(coap_message_t *response);
+
+#endif /* COAP_CHUNKED_H_ */
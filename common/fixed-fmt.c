@@ -0,0 +1,80 @@
+#include <stdbool.h>
+#include <string.h>
+#include "fixed-fmt.h"
+
+static const uint32_t pow10[FMT_MAX_PRECISION + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+static char *fmt_uint(char *out, unsigned long value)
+{
+    char digits[20]; // 64-bit long on the native target
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    while (n > 0)
+        *out++ = digits[--n];
+    *out = '\0';
+    return out;
+}
+
+char *fmt_fixed(char *out, float value, uint8_t precision)
+{
+    if (value != value) // NaN
+        return fmt_str(out, "nan");
+
+    if (precision > FMT_MAX_PRECISION)
+        precision = FMT_MAX_PRECISION;
+
+    bool negative = value < 0.0f;
+    float magnitude = negative ? -value : value;
+    if (magnitude >= 4294967295.0f)
+        return fmt_str(out, negative ? "-inf" : "inf");
+
+    // integer and rounded fraction parts
+    uint32_t integer = (uint32_t) magnitude;
+    uint32_t fraction = (uint32_t) ((magnitude - integer) * pow10[precision] + 0.5f);
+    if (fraction >= pow10[precision]) {
+        integer++;
+        fraction -= pow10[precision];
+    }
+
+    if (negative && (integer != 0 || fraction != 0))
+        *out++ = '-';
+    out = fmt_uint(out, integer);
+
+    if (precision > 0) {
+        *out++ = '.';
+        for (int i = precision - 1; i >= 0; i--) {
+            out[i] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        out += precision;
+        *out = '\0';
+    }
+    return out;
+}
+
+char *fmt_int(char *out, long value)
+{
+    if (value < 0) {
+        *out++ = '-';
+        return fmt_uint(out, 0UL - (unsigned long) value); // LONG_MIN too
+    }
+    return fmt_uint(out, (unsigned long) value);
+}
+
+char *fmt_str(char *out, const char *s)
+{
+    size_t len = strlen(s);
+    memcpy(out, s, len + 1);
+    return out + len;
+}
+
+char *fmt_float(float value, char *output)
+{
+    fmt_fixed(output, value, FMT_PRECISION);
+    return output;
+}
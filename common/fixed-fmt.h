@@ -0,0 +1,34 @@
+#ifndef FIXED_FMT_H_
+#define FIXED_FMT_H_
+
+#include <stdint.h>
+
+// Fixed-point number formatting without printf.
+// The fmt_* writers append at out, NUL-terminate and return the position of
+// the terminator, so payloads are built by chaining calls. Callers size the
+// buffer: a float or a 32-bit integer takes at most FMT_FLOAT_BUF_SIZE
+// bytes. Floats are formatted through 32-bit integers: a magnitude of 2^32
+// or more is written "inf" or "-inf", like the infinities, and NaN "nan".
+
+#ifdef FMT_CONF_PRECISION
+#define FMT_PRECISION FMT_CONF_PRECISION
+#else
+#define FMT_PRECISION 3 // decimal digits
+#endif
+
+#define FMT_MAX_PRECISION 6
+#define FMT_FLOAT_BUF_SIZE (12 + FMT_MAX_PRECISION + 1) // sign, 10 digits, point
+
+#if FMT_PRECISION > FMT_MAX_PRECISION
+#error "FMT_CONF_PRECISION is above FMT_MAX_PRECISION"
+#endif
+
+char *fmt_fixed(char *out, float value, uint8_t precision);
+char *fmt_int(char *out, long value); // the whole range of long
+char *fmt_str(char *out, const char *s);
+
+// value with FMT_PRECISION digits into output, returns output for use in
+// LOG arguments (output of FMT_FLOAT_BUF_SIZE bytes)
+char *fmt_float(float value, char *output);
+
+#endif /* FIXED_FMT_H_ */
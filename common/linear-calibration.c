@@ -0,0 +1,51 @@
+#include <string.h>
+#include "linear-calibration.h"
+#include "fixed-fmt.h"
+
+static float clamp(float value, float min, float max)
+{
+    return value < min ? min : value > max ? max : value;
+}
+
+void linear_calibration_update(linear_calibration_t *cal, float x, float y)
+{
+    linear_calibration_fit_t *fit = &cal->fit;
+
+    // 1/n: plain averages until the forgetting takes over
+    fit->samples++;
+    float alpha = 1.0f / fit->samples;
+    if (alpha < LINEAR_CALIBRATION_ALPHA)
+        alpha = LINEAR_CALIBRATION_ALPHA;
+
+    float dx = x - fit->mean_x;
+    float dy = y - fit->mean_y;
+    fit->mean_x += alpha * dx;
+    fit->mean_y += alpha * dy;
+    fit->var_x = (1.0f - alpha) * (fit->var_x + alpha * dx * dx);
+    fit->cov_xy = (1.0f - alpha) * (fit->cov_xy + alpha * dx * dy);
+
+    if (fit->var_x >= cal->min_spread * cal->min_spread)
+        fit->gain = clamp(fit->cov_xy / fit->var_x, cal->gain_min, cal->gain_max);
+    fit->offset = clamp(fit->mean_y - fit->gain * fit->mean_x, -cal->offset_max, cal->offset_max);
+}
+
+float linear_calibration_apply(const linear_calibration_t *cal, float x)
+{
+    return cal->fit.gain * x + cal->fit.offset;
+}
+
+void linear_calibration_reset(linear_calibration_t *cal)
+{
+    memset(&cal->fit, 0, sizeof(cal->fit));
+    cal->fit.gain = 1.0f;
+}
+
+char *linear_calibration_json(char *out, const linear_calibration_t *cal)
+{
+    out = fmt_str(out, "\"gain\":");
+    out = fmt_fixed(out, cal->fit.gain, 4);
+    out = fmt_str(out, ",\"offset\":");
+    out = fmt_fixed(out, cal->fit.offset, 1);
+    out = fmt_str(out, ",\"samples\":");
+    return fmt_int(out, cal->fit.samples);
+}
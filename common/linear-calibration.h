@@ -0,0 +1,53 @@
+#ifndef LINEAR_CALIBRATION_H_
+#define LINEAR_CALIBRATION_H_
+
+#include <stdint.h>
+
+// Online gain/offset correction of a model output: y ~= gain * x + offset,
+// fitted by least squares on pairs of (model output x, measurement y).
+// The means, variance and covariance are running averages: exact least
+// squares over the first 1 / LINEAR_CALIBRATION_ALPHA pairs, then an
+// exponential forgetting so that the fit follows a slow drift. O(1)
+// memory. The gain is fitted only once x has moved by min_spread
+// (standard deviation), else the previous one is kept and only the
+// offset follows. Both stay within bounds, so that a bad batch of
+// pairs cannot take the correction far from the model.
+
+#ifdef LINEAR_CALIBRATION_CONF_ALPHA
+#define LINEAR_CALIBRATION_ALPHA LINEAR_CALIBRATION_CONF_ALPHA
+#else
+#define LINEAR_CALIBRATION_ALPHA 0.02f // weight of the last pair, once settled
+#endif
+
+// Correction and state, in one block to be saved as a whole
+typedef struct {
+    float gain; // 1 and 0: no correction
+    float offset;
+    float mean_x;
+    float mean_y;
+    float var_x;
+    float cov_xy;
+    uint32_t samples;
+} linear_calibration_fit_t;
+
+typedef struct {
+    float gain_min; // bounds of the correction
+    float gain_max;
+    float offset_max; // +/-, unit of y
+    float min_spread; // of x, to fit the gain
+    linear_calibration_fit_t fit;
+} linear_calibration_t;
+
+// Adds a pair of model output x and measurement y, updates the correction
+void linear_calibration_update(linear_calibration_t *cal, float x, float y);
+
+// Corrected model output
+float linear_calibration_apply(const linear_calibration_t *cal, float x);
+
+// Back to no correction, without pairs
+void linear_calibration_reset(linear_calibration_t *cal);
+
+// "gain":g,"offset":o,"samples":n into out, returns the end
+char *linear_calibration_json(char *out, const linear_calibration_t *cal);
+
+#endif /* LINEAR_CALIBRATION_H_ */
@@ -0,0 +1,60 @@
+#ifndef NODE_BENCH_H_
+#define NODE_BENCH_H_
+
+// Timing helpers for the TARGET=native benchmark builds (make bench).
+// Host only: uses the POSIX monotonic clock.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef NODE_BENCH_CONF_ITERATIONS
+#define NODE_BENCH_ITERATIONS NODE_BENCH_CONF_ITERATIONS
+#else
+#define NODE_BENCH_ITERATIONS 100000UL
+#endif
+
+static inline uint64_t
+node_bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static inline void
+node_bench_header(const char *node)
+{
+    printf("Benchmark %s (%lu iterations)\n", node, (unsigned long) NODE_BENCH_ITERATIONS);
+    printf("%-28s %12s %12s\n", "function", "ns/op", "bytes/op");
+}
+
+static inline void
+node_bench_report(const char *name, unsigned long n, uint64_t ns, uint64_t bytes)
+{
+    printf("%-28s %12.1f %12.1f\n", name, (double) ns / n, (double) bytes / n);
+}
+
+// Run op n times; bytes is evaluated after each op (payload size, 0 if none)
+#define NODE_BENCH(name, n, op, bytes) do {                          \
+        uint64_t bench_bytes_ = 0;                                    \
+        uint64_t bench_start_ = node_bench_now_ns();                  \
+        for (unsigned long bench_i_ = 0; bench_i_ < (n); bench_i_++) { \
+            op;                                                       \
+            bench_bytes_ += (bytes);                                  \
+        }                                                             \
+        node_bench_report(name, (n), node_bench_now_ns() - bench_start_, bench_bytes_); \
+    } while (0)
+
+// Run op, which handles k samples, for n samples: the ns/op column is
+// then nanoseconds per sample, not per call
+#define NODE_BENCH_BATCH(name, n, k, op) do {                        \
+        unsigned long bench_n_ = (n) / (k);                           \
+        uint64_t bench_start_ = node_bench_now_ns();                  \
+        for (unsigned long bench_i_ = 0; bench_i_ < bench_n_; bench_i_++) { \
+            op;                                                       \
+        }                                                             \
+        node_bench_report(name, bench_n_ * (k), node_bench_now_ns() - bench_start_, 0); \
+    } while (0)
+
+#endif /* NODE_BENCH_H_ */
@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include <string.h>
+#include "node-config.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "cfs/cfs.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "CONF"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+#define CONFIG_BASE_NAME "config/"
+
+// File: for each entry, name length, name and value (float)
+#define CONFIG_FILE_SIZE (CONFIG_MAX_ENTRIES * 24)
+
+// New values of a load or a PUT, applied together
+typedef struct {
+    const config_t *config;
+    float values[CONFIG_MAX_ENTRIES];
+    uint16_t set; // entries with a new value
+    bool error;
+} config_update_t;
+
+float config_get(const config_entry_t *entry)
+{
+    switch (entry->type) {
+        case CONFIG_INT:
+            return *(int32_t *) entry->value;
+        case CONFIG_FLOAT:
+            return *(float *) entry->value;
+        case CONFIG_INTERVAL:
+            return (float) *(clock_time_t *) entry->value / CLOCK_SECOND;
+    }
+    return 0.0f;
+}
+
+static void config_set(const config_entry_t *entry, float value)
+{
+    switch (entry->type) {
+        case CONFIG_INT:
+            *(int32_t *) entry->value = (int32_t) value;
+            break;
+        case CONFIG_FLOAT:
+            *(float *) entry->value = value;
+            break;
+        case CONFIG_INTERVAL:
+            *(clock_time_t *) entry->value = (clock_time_t) (value * CLOCK_SECOND + 0.5f);
+            break;
+    }
+}
+
+// Stages value for the entry called name, if it is valid
+static void update_add(config_update_t *update, const char *name, int name_len, float value)
+{
+    const config_t *config = update->config;
+
+    for (uint8_t i = 0; i < config->n_entries; i++) {
+        const config_entry_t *entry = &config->entries[i];
+        if (name_len != (int) strlen(entry->name) || strncmp(name, entry->name, name_len) != 0)
+            continue;
+
+        // written so that NaN is out of range too
+        if (!(value >= entry->min && value <= entry->max)
+            || (entry->type == CONFIG_INT && value != (float) (int32_t) value)) {
+            LOG_WARN("Invalid %s\n", entry->name);
+            update->error = true;
+            return;
+        }
+        update->values[i] = value;
+        update->set |= 1 << i;
+        return;
+    }
+    LOG_WARN("Unknown parameter: %.*s\n", name_len, name);
+    update->error = true;
+}
+
+// All the staged values or, if one is wrong, none
+static bool update_apply(config_update_t *update)
+{
+    const config_t *config = update->config;
+    float old[CONFIG_MAX_ENTRIES];
+
+    if (update->error || update->set == 0)
+        return false;
+
+    for (uint8_t i = 0; i < config->n_entries; i++) {
+        old[i] = config_get(&config->entries[i]);
+        if (update->set & (1 << i))
+            config_set(&config->entries[i], update->values[i]);
+    }
+
+    if (config->check != NULL && !config->check()) {
+        for (uint8_t i = 0; i < config->n_entries; i++)
+            config_set(&config->entries[i], old[i]);
+        return false;
+    }
+
+    if (config->changed != NULL)
+        config->changed();
+    return true;
+}
+
+static bool config_save(const config_t *config)
+{
+    uint8_t file[CONFIG_FILE_SIZE];
+    int size = 0;
+
+    for (uint8_t i = 0; i < config->n_entries; i++) {
+        const config_entry_t *entry = &config->entries[i];
+        uint8_t name_len = strlen(entry->name);
+        float value = config_get(entry);
+
+        if (size + 1 + name_len + sizeof(value) > sizeof(file))
+            return false;
+        file[size++] = name_len;
+        memcpy(file + size, entry->name, name_len);
+        size += name_len;
+        memcpy(file + size, &value, sizeof(value));
+        size += sizeof(value);
+    }
+
+    // a new file, not the tail of the old one
+    cfs_remove(config->file);
+    int fd = cfs_open(config->file, CFS_WRITE);
+    if (fd < 0)
+        return false;
+    int written = cfs_write(fd, file, size);
+    cfs_close(fd);
+    return written == size;
+}
+
+void config_load(const config_t *config)
+{
+    uint8_t file[CONFIG_FILE_SIZE];
+    config_update_t update = { config };
+    int fd = cfs_open(config->file, CFS_READ);
+
+    if (fd >= 0) {
+        int size = cfs_read(fd, file, sizeof(file));
+        int pos = 0;
+        cfs_close(fd);
+
+        // entries that are no longer in the table are ignored
+        while (pos < size) {
+            uint8_t name_len = file[pos];
+            float value;
+            if (pos + 1 + name_len + (int) sizeof(value) > size)
+                break;
+            memcpy(&value, file + pos + 1 + name_len, sizeof(value));
+            update_add(&update, (const char *) file + pos + 1, name_len, value);
+            pos += 1 + name_len + sizeof(value);
+        }
+    }
+
+    // the saved values that are still valid
+    update.error = false;
+    bool applied = update.set != 0 && update_apply(&update);
+    if (applied)
+        LOG_INFO("Configuration loaded from %s\n", config->file);
+    else if (update.set != 0)
+        LOG_WARN("Saved configuration rejected, using the defaults\n");
+
+    if (!applied && config->changed != NULL)
+        config->changed();
+}
+
+// Ends a number without its trailing zeros
+static char *trim_zeros(char *start, char *end)
+{
+    if (strchr(start, '.') == NULL)
+        return end;
+    while (end[-1] == '0')
+        end--;
+    if (end[-1] == '.')
+        end--;
+    *end = '\0';
+    return end;
+}
+
+static void config_json_generator(coap_chunked_t *out, void *data)
+{
+    const config_t *config = data;
+    char buffer[32 + FMT_FLOAT_BUF_SIZE];
+
+    coap_chunked_put(out, "{\"n\":\"config\"");
+    for (uint8_t i = 0; i < config->n_entries; i++) {
+        const config_entry_t *entry = &config->entries[i];
+        char *p = fmt_str(buffer, ",\"");
+        p = fmt_str(p, entry->name);
+        p = fmt_str(p, "\":");
+        trim_zeros(p, fmt_fixed(p, config_get(entry), entry->type == CONFIG_INT ? 0 : FMT_MAX_PRECISION));
+        coap_chunked_put(out, buffer);
+    }
+    coap_chunked_put(out, "}");
+}
+
+static void config_senml_cbor_generator(coap_chunked_t *out, void *data)
+{
+    const config_t *config = data;
+    uint8_t buffer[40];
+
+    coap_chunked_write(out, buffer, senml_cbor_pack(buffer, config->n_entries) - buffer);
+    for (uint8_t i = 0; i < config->n_entries; i++) {
+        const config_entry_t *entry = &config->entries[i];
+        uint8_t *p = senml_cbor_record(buffer, i == 0 ? CONFIG_BASE_NAME : NULL, entry->name, config_get(entry));
+        coap_chunked_write(out, buffer, p - buffer);
+    }
+}
+
+void config_get_handler(const config_t *config, coap_message_t *request, coap_message_t *response,
+                        uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    unsigned int format = APPLICATION_JSON;
+
+    switch (senml_cbor_select_format(request, offset, &format)) {
+        case SENML_CBOR_CONTENT_FORMAT:
+            coap_chunked_respond(response, buffer, preferred_size, offset, SENML_CBOR_CONTENT_FORMAT,
+                                 config_senml_cbor_generator, (void *) config);
+            break;
+        case APPLICATION_JSON:
+            coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON,
+                                 config_json_generator, (void *) config);
+            break;
+        default:
+            coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+            break;
+    }
+}
+
+// The SenML decoder has no context for its callback
+static config_update_t *decoding;
+
+static void decode_record(const char *base_name, uint8_t base_name_len, const char *name, uint8_t name_len, float value)
+{
+    // names are relative to "config/"
+    if (base_name_len != 0 && (base_name_len != strlen(CONFIG_BASE_NAME)
+                               || strncmp(base_name, CONFIG_BASE_NAME, base_name_len) != 0)) {
+        decoding->error = true;
+        return;
+    }
+    update_add(decoding, name, name_len, value);
+}
+
+// name=value&... of a form payload, every key staged so that an unknown
+// one is an error too
+static void decode_form(config_update_t *update, const char *form, int len)
+{
+    const char *end = form + len;
+
+    while (form < end && !update->error) {
+        const char *pair_end = memchr(form, '&', end - form);
+        if (pair_end == NULL)
+            pair_end = end;
+        const char *equal = memchr(form, '=', pair_end - form);
+        int value_len = equal != NULL ? pair_end - equal - 1 : 0;
+        char str[16];
+        char *value_end;
+
+        if (equal == NULL || equal == form || value_len <= 0 || value_len >= sizeof(str)) {
+            LOG_WARN("Malformed parameter: %.*s\n", (int) (pair_end - form), form);
+            update->error = true;
+            return;
+        }
+        memcpy(str, equal + 1, value_len);
+        str[value_len] = '\0';
+        float value = strtof(str, &value_end);
+        if (value_end == str || *value_end != '\0') {
+            LOG_WARN("Invalid %.*s\n", (int) (equal - form), form);
+            update->error = true;
+            return;
+        }
+        update_add(update, form, equal - form, value);
+        form = pair_end + 1;
+    }
+}
+
+void config_put_handler(const config_t *config, coap_message_t *request, coap_message_t *response)
+{
+    config_update_t update = { config };
+    unsigned int format = APPLICATION_JSON;
+
+    const uint8_t *payload = NULL;
+    int len = coap_get_payload(request, &payload);
+
+    coap_get_header_content_format(request, &format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        decoding = &update;
+        if (senml_cbor_decode(payload, len, decode_record) < 0)
+            update.error = true;
+        decoding = NULL;
+    } else {
+        decode_form(&update, (const char *) payload, len);
+    }
+
+    if (!update_apply(&update)) {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+        return;
+    }
+
+    if (!config_save(config))
+        LOG_WARN("Configuration applied but not saved\n");
+    coap_set_status_code(response, CHANGED_2_04);
+}
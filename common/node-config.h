@@ -0,0 +1,55 @@
+#ifndef NODE_CONFIG_H_
+#define NODE_CONFIG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-chunked.h"
+
+// Runtime configuration of a node: a table of typed parameters, read
+// and written by the config resource and kept in a CFS file so that the
+// values survive a reboot. The defaults are the initial values of the
+// variables the entries point to.
+// Every value is exchanged as a number: intervals in seconds.
+
+#ifdef CONFIG_CONF_MAX_ENTRIES
+#define CONFIG_MAX_ENTRIES CONFIG_CONF_MAX_ENTRIES
+#else
+#define CONFIG_MAX_ENTRIES 12
+#endif
+
+typedef enum { CONFIG_INT, CONFIG_FLOAT, CONFIG_INTERVAL } config_type_t;
+
+typedef struct {
+    const char *name;
+    config_type_t type;
+    void *value; // int32_t, float or clock_time_t
+    float min;
+    float max;
+} config_entry_t;
+
+typedef struct {
+    const char *file; // CFS file name
+    const config_entry_t *entries;
+    uint8_t n_entries;
+    bool (*check)(void);   // consistency of the new values, NULL: none
+    void (*changed)(void); // applies the new values, NULL: nothing to do
+} config_t;
+
+float config_get(const config_entry_t *entry);
+
+// Loads the values saved in the file, if any, then calls changed()
+void config_load(const config_t *config);
+
+// GET: {"n":"config","<name>":<value>,...} or SenML-CBOR "config/<name>"
+// records, see senml-cbor.h
+void config_get_handler(const config_t *config, coap_message_t *request, coap_message_t *response,
+                        uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// PUT: name=value&... or SenML-CBOR records with the values to change.
+// All of them are applied and saved or, if one is unknown, out of range
+// or check() fails, none.
+void config_put_handler(const config_t *config, coap_message_t *request, coap_message_t *response);
+
+#endif /* NODE_CONFIG_H_ */
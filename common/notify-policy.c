@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include "notify-policy.h"
+#include "fixed-fmt.h"
+#include "coap-transactions.h"
+
+bool notify_policy_check(notify_policy_t *policy, const float *values)
+{
+    clock_time_t now = clock_time();
+    clock_time_t elapsed = now - policy->last_time;
+    bool changed = !policy->notified;
+
+    for (uint8_t i = 0; i < policy->n_values && !changed; i++) {
+        float delta = values[i] - policy->last[i];
+        if (delta < 0.0f)
+            delta = -delta;
+        changed = delta > policy->threshold[i] || (policy->threshold[i] == 0.0f && delta != 0.0f);
+    }
+
+    if (!((changed && elapsed >= policy->pmin) || elapsed >= policy->pmax)) {
+        policy->suppressed++;
+        return false;
+    }
+
+    memcpy(policy->last, values, policy->n_values * sizeof(float));
+    policy->last_time = now;
+    policy->notified = true;
+    policy->sent++;
+    return true;
+}
+
+// Variable from the query, else from the POST payload, NUL-terminated
+static bool get_variable(coap_message_t *request, const char *name, char *value, int size)
+{
+    const char *var = NULL;
+    int len = coap_get_query_variable(request, name, &var);
+    if (len <= 0)
+        len = coap_get_post_variable(request, name, &var);
+    if (len <= 0 || len >= size)
+        return false;
+    memcpy(value, var, len);
+    value[len] = '\0';
+    return true;
+}
+
+static bool parse_seconds(const char *str, clock_time_t *value)
+{
+    char *end;
+    long seconds = strtol(str, &end, 10);
+    if (end == str || *end != '\0' || seconds < 0 || seconds > 86400)
+        return false;
+    *value = seconds * CLOCK_SECOND;
+    return true;
+}
+
+bool notify_policy_configure(notify_policy_t *policy, coap_message_t *request)
+{
+    char str[48];
+    clock_time_t pmin = policy->pmin, pmax = policy->pmax;
+    float threshold[NOTIFY_POLICY_MAX_VALUES];
+
+    memcpy(threshold, policy->threshold, sizeof(threshold));
+
+    if (get_variable(request, "pmin", str, sizeof(str)) && !parse_seconds(str, &pmin))
+        return false;
+    if (get_variable(request, "pmax", str, sizeof(str)) && !parse_seconds(str, &pmax))
+        return false;
+    if (pmax < pmin)
+        return false;
+
+    if (get_variable(request, "st", str, sizeof(str))) {
+        char *p = str;
+        uint8_t n = 0;
+        while (n < policy->n_values) {
+            char *end;
+            threshold[n] = strtof(p, &end);
+            if (end == p || threshold[n] < 0.0f)
+                return false;
+            n++;
+            if (*end == '\0')
+                break;
+            if (*end != ',')
+                return false;
+            p = end + 1;
+        }
+        if (n == 1) // one threshold for all the values
+            for (uint8_t i = 1; i < policy->n_values; i++)
+                threshold[i] = threshold[0];
+        else if (n != policy->n_values)
+            return false;
+    }
+
+    policy->pmin = pmin;
+    policy->pmax = pmax;
+    memcpy(policy->threshold, threshold, sizeof(threshold));
+    return true;
+}
+
+uint32_t notify_policy_max_age(const notify_policy_t *policy, clock_time_t trigger_interval)
+{
+    if (trigger_interval == 0)
+        return NOTIFY_MAX_AGE_IDLE;
+    return (policy->pmax + trigger_interval + CLOCK_SECOND - 1) / CLOCK_SECOND;
+}
+
+char *notify_policy_json(char *out, const char *name, const notify_policy_t *policy)
+{
+    out = fmt_str(out, "\"");
+    out = fmt_str(out, name);
+    out = fmt_str(out, "\":[");
+    out = fmt_int(out, policy->sent);
+    out = fmt_str(out, ",");
+    out = fmt_int(out, policy->suppressed);
+    return fmt_str(out, "]");
+}
+
+// CON notifications waiting for their ACK: no more than the transactions
+typedef struct {
+    notify_delivery_t *delivery;
+    clock_time_t sent;
+    clock_time_t timeout; // first retransmission
+} delivery_slot_t;
+
+static delivery_slot_t slots[COAP_MAX_OPEN_TRANSACTIONS];
+
+// CON notifications of the coap_notify_observers() call in progress
+static uint16_t sent_mids[COAP_MAX_OPEN_TRANSACTIONS];
+static uint8_t n_sent;
+
+void notify_delivery_prepare(notify_delivery_t *delivery, coap_message_t *response)
+{
+    // the refresh of Contiki is per observer, the handler is called once
+    // for each of them: its CON stays
+    if (!delivery->confirmable && response->type != COAP_TYPE_CON) {
+        response->type = COAP_TYPE_NON;
+        delivery->non++;
+        return;
+    }
+
+    response->type = COAP_TYPE_CON;
+    delivery->con++;
+    if (n_sent < COAP_MAX_OPEN_TRANSACTIONS)
+        sent_mids[n_sent++] = response->mid;
+}
+
+// ACK (response) or timeout (NULL) of a CON notification
+static void delivery_callback(void *data, void *response)
+{
+    delivery_slot_t *slot = data;
+    notify_delivery_t *delivery = slot->delivery;
+
+    if (response == NULL) {
+        delivery->lost++;
+        delivery->retransmissions += COAP_MAX_RETRANSMIT;
+    } else {
+        // the transaction is gone: retransmissions from the ACK time, the
+        // timeout doubles at each of them
+        clock_time_t elapsed = clock_time() - slot->sent;
+        clock_time_t next = slot->timeout;
+        uint8_t n = 0;
+        while (n < COAP_MAX_RETRANSMIT && elapsed >= next)
+            next += slot->timeout << ++n;
+        delivery->acked++;
+        delivery->retransmissions += n;
+    }
+    slot->delivery = NULL;
+}
+
+void notify_delivery_notify(notify_delivery_t *delivery, coap_resource_t *resource)
+{
+    n_sent = 0;
+    coap_notify_observers(resource);
+
+    for (uint8_t i = 0; i < n_sent; i++) {
+        coap_transaction_t *t = coap_get_transaction_by_mid(sent_mids[i]);
+        if (t == NULL)
+            continue;
+
+        delivery_slot_t *slot = NULL;
+        for (uint8_t s = 0; s < COAP_MAX_OPEN_TRANSACTIONS && slot == NULL; s++)
+            if (slots[s].delivery == NULL)
+                slot = &slots[s];
+        if (slot == NULL)
+            break;
+
+        slot->delivery = delivery;
+        slot->sent = clock_time();
+        slot->timeout = (clock_time_t) t->retrans_interval * CLOCK_SECOND / 1000; // ms
+        t->callback = delivery_callback;
+        t->callback_data = slot;
+    }
+    n_sent = 0;
+}
+
+char *notify_delivery_json(char *out, const char *name, const notify_delivery_t *delivery)
+{
+    out = fmt_str(out, "\"");
+    out = fmt_str(out, name);
+    out = fmt_str(out, "\":[");
+    out = fmt_int(out, delivery->non);
+    out = fmt_str(out, ",");
+    out = fmt_int(out, delivery->con);
+    out = fmt_str(out, ",");
+    out = fmt_int(out, delivery->acked);
+    out = fmt_str(out, ",");
+    out = fmt_int(out, delivery->lost);
+    out = fmt_str(out, ",");
+    out = fmt_int(out, delivery->retransmissions);
+    return fmt_str(out, "]");
+}
@@ -0,0 +1,76 @@
+#ifndef NOTIFY_POLICY_H_
+#define NOTIFY_POLICY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "contiki.h"
+#include "coap-engine.h"
+
+// Change-of-value notification policy of an observable resource.
+// On each trigger the resource notifies only if a value moved by more
+// than its threshold since the last notification and pmin has elapsed,
+// or if pmax has elapsed (heartbeat). Triggers must come at least every
+// pmax for the heartbeat to be on time.
+
+#define NOTIFY_POLICY_MAX_VALUES 4
+
+typedef struct {
+    uint8_t n_values;
+    float threshold[NOTIFY_POLICY_MAX_VALUES]; // 0: notify on any change
+    clock_time_t pmin;
+    clock_time_t pmax;
+    // state
+    bool notified;
+    float last[NOTIFY_POLICY_MAX_VALUES];
+    clock_time_t last_time;
+    uint32_t sent;
+    uint32_t suppressed;
+} notify_policy_t;
+
+// True if the observers have to be notified of values (n_values of them),
+// which then become the reference for the next changes
+bool notify_policy_check(notify_policy_t *policy, const float *values);
+
+// Sets pmin, pmax (seconds) and st (threshold, one for all values or a
+// comma separated list) from the query or the POST payload of request.
+// Returns false, changing nothing, if a variable is malformed.
+bool notify_policy_configure(notify_policy_t *policy, coap_message_t *request);
+
+// Max-Age (seconds) of a notification: the next one is due at the latest
+// at the first trigger after pmax, trigger_interval being the longest gap
+// between triggers (0: no more triggers until a status change, then
+// NOTIFY_MAX_AGE_IDLE). Observers can take it as the silence to tolerate.
+#define NOTIFY_MAX_AGE_IDLE 86400
+uint32_t notify_policy_max_age(const notify_policy_t *policy, clock_time_t trigger_interval);
+
+// "<name>":[sent,suppressed] into out, returns the end
+char *notify_policy_json(char *out, const char *name, const notify_policy_t *policy);
+
+// Message type of the notifications of a resource and their delivery.
+// State changes go CON and are tracked until their ACK or timeout (then
+// Contiki drops the observer). Telemetry goes NON, except the CON that
+// Contiki forces every COAP_OBSERVE_REFRESH_INTERVAL notifications of each
+// observer, so that dead observers are still detected: those are kept,
+// counted and tracked as the others.
+
+typedef struct {
+    bool confirmable;
+    // state
+    uint32_t non;
+    uint32_t con;
+    uint32_t acked;
+    uint32_t lost;
+    uint32_t retransmissions;
+} notify_delivery_t;
+
+// Sets the message type of a notification, from the GET handler
+// (offset == NULL). A CON set by Contiki is never turned into a NON.
+void notify_delivery_prepare(notify_delivery_t *delivery, coap_message_t *response);
+
+// coap_notify_observers() tracking the CON notifications sent
+void notify_delivery_notify(notify_delivery_t *delivery, coap_resource_t *resource);
+
+// "<name>":[non,con,acked,lost,retransmissions] into out, returns the end
+char *notify_delivery_json(char *out, const char *name, const notify_delivery_t *delivery);
+
+#endif /* NOTIFY_POLICY_H_ */
@@ -0,0 +1,97 @@
+#include "profile.h"
+#include "fixed-fmt.h"
+#include "sys/energest.h"
+
+void profile_stop(profile_t *profile, rtimer_clock_t start)
+{
+    uint32_t ticks = RTIMER_CLOCK_DIFF(RTIMER_NOW(), start);
+
+    profile->calls++;
+    profile->ticks += ticks;
+    if (ticks > profile->max)
+        profile->max = ticks;
+}
+
+static uint32_t ticks_to_us(uint32_t ticks)
+{
+    return (uint64_t) ticks * 1000000 / RTIMER_SECOND;
+}
+
+static void put_energest(coap_chunked_t *out, const char *name, uint64_t time)
+{
+    char buffer[32];
+    char *p = fmt_str(buffer, ",\"");
+    p = fmt_str(p, name);
+    p = fmt_str(p, "\":");
+    fmt_int(p, time * 1000 / ENERGEST_SECOND);
+    coap_chunked_put(out, buffer);
+}
+
+void profile_energest_json(coap_chunked_t *out, profile_t *const *profiles)
+{
+    char buffer[64];
+
+    energest_flush();
+    coap_chunked_put(out, "{\"n\":\"energest\"");
+    put_energest(out, "cpu", energest_type_time(ENERGEST_TYPE_CPU));
+    put_energest(out, "lpm", energest_type_time(ENERGEST_TYPE_LPM));
+    put_energest(out, "deep", energest_type_time(ENERGEST_TYPE_DEEP_LPM));
+    put_energest(out, "tx", energest_type_time(ENERGEST_TYPE_TRANSMIT));
+    put_energest(out, "rx", energest_type_time(ENERGEST_TYPE_LISTEN));
+    put_energest(out, "total", ENERGEST_GET_TOTAL_TIME());
+
+    for (; *profiles != NULL; profiles++) {
+        char *p = fmt_str(buffer, ",\"");
+        p = fmt_str(p, (*profiles)->name);
+        p = fmt_str(p, "\":[");
+        p = fmt_int(p, (*profiles)->calls);
+        p = fmt_str(p, ",");
+        p = fmt_int(p, ticks_to_us((*profiles)->ticks));
+        p = fmt_str(p, ",");
+        p = fmt_int(p, ticks_to_us((*profiles)->max));
+        fmt_str(p, "]");
+        coap_chunked_put(out, buffer);
+    }
+    coap_chunked_put(out, "}");
+}
+
+void latency_record(latency_t *latency, rtimer_clock_t start)
+{
+    uint32_t ticks = RTIMER_CLOCK_DIFF(RTIMER_NOW(), start);
+    uint8_t bucket = 0;
+
+    while (ticks >> bucket != 0 && bucket < LATENCY_BUCKETS - 1)
+        bucket++;
+    if (latency->buckets[bucket] < UINT16_MAX)
+        latency->buckets[bucket]++;
+    if (ticks > latency->max)
+        latency->max = ticks;
+}
+
+void latency_json(coap_chunked_t *out, latency_t *const *latencies)
+{
+    char buffer[48]; // ,"<name>":{"max_us":<max>,"b":[ with names up to 16
+    char *p = fmt_str(buffer, "{\"n\":\"latency\",\"tick_us\":");
+    fmt_fixed(p, 1000000.0f / RTIMER_SECOND, 1);
+    coap_chunked_put(out, buffer);
+
+    for (; *latencies != NULL; latencies++) {
+        const latency_t *latency = *latencies;
+        int last = LATENCY_BUCKETS - 1;
+        while (last > 0 && latency->buckets[last] == 0)
+            last--;
+
+        p = fmt_str(buffer, ",\"");
+        p = fmt_str(p, latency->name);
+        p = fmt_str(p, "\":{\"max_us\":");
+        p = fmt_int(p, ticks_to_us(latency->max));
+        fmt_str(p, ",\"b\":[");
+        coap_chunked_put(out, buffer);
+        for (int i = 0; i <= last; i++) {
+            p = fmt_int(buffer, latency->buckets[i]);
+            fmt_str(p, i < last ? "," : "]}");
+            coap_chunked_put(out, buffer);
+        }
+    }
+    coap_chunked_put(out, "}");
+}
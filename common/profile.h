@@ -0,0 +1,80 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include "contiki.h"
+#include "sys/rtimer.h"
+#include "coap-engine.h"
+#include "coap-chunked.h"
+
+// CPU time of code sections with the rtimer clock:
+//     rtimer_clock_t start = profile_start();
+//     ...
+//     profile_stop(&profile_x, start);
+// Served with the energest times of the node (ENERGEST_CONF_ON) by
+// diag/energest.
+
+typedef struct {
+    const char *name;
+    uint32_t calls;
+    uint32_t ticks; // rtimer ticks, all the calls
+    uint32_t max;   // rtimer ticks, longest call
+} profile_t;
+
+static inline rtimer_clock_t profile_start(void)
+{
+    return RTIMER_NOW();
+}
+
+void profile_stop(profile_t *profile, rtimer_clock_t start);
+
+// {"n":"energest","cpu":..,"lpm":..,"deep":..,"tx":..,"rx":..,"total":..,
+//  "<name>":[calls,us,max_us],...} with the times in ms since boot and
+// the sections of profiles (NULL terminated)
+void profile_energest_json(coap_chunked_t *out, profile_t *const *profiles);
+
+// Latency histogram of a CoAP handler, log-scale in rtimer ticks:
+// bucket 0 counts the calls under a tick, bucket k those in
+// [2^(k-1), 2^k) ticks, the last one everything longer.
+//     LATENCY_HANDLER(relay_post, res_post_put_handler)
+// defines latency_relay_post and res_post_put_handler_timed(), to be
+// given to the RESOURCE definition instead of the handler.
+
+#ifdef LATENCY_CONF_BUCKETS
+#define LATENCY_BUCKETS LATENCY_CONF_BUCKETS
+#else
+#define LATENCY_BUCKETS 12 // up to 2^10 ticks, 31 ms at 32768 Hz
+#endif
+
+typedef struct {
+    const char *name;
+    uint16_t buckets[LATENCY_BUCKETS];
+    uint32_t max; // rtimer ticks
+} latency_t;
+
+void latency_record(latency_t *latency, rtimer_clock_t start);
+
+#define LATENCY_HANDLER(name, handler)                                          \
+    latency_t latency_##name = { #name };                                       \
+    static void handler##_timed(coap_message_t *request, coap_message_t *response, \
+                                uint8_t *buffer, uint16_t preferred_size, int32_t *offset) \
+    {                                                                           \
+        rtimer_clock_t start = profile_start();                                 \
+        handler(request, response, buffer, preferred_size, offset);             \
+        latency_record(&latency_##name, start);                                 \
+    }
+
+#define LATENCY_EVENT_HANDLER(name, handler)                                    \
+    latency_t latency_##name = { #name };                                       \
+    static void handler##_timed(void)                                           \
+    {                                                                           \
+        rtimer_clock_t start = profile_start();                                 \
+        handler();                                                              \
+        latency_record(&latency_##name, start);                                 \
+    }
+
+// {"n":"latency","tick_us":..,"<name>":{"max_us":..,"b":[bucket,...]},...} of
+// latencies (NULL terminated), without the trailing empty buckets
+void latency_json(coap_chunked_t *out, latency_t *const *latencies);
+
+#endif /* PROFILE_H_ */
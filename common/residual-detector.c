@@ -0,0 +1,51 @@
+#include <math.h>
+#include "residual-detector.h"
+#include "fixed-fmt.h"
+
+enum residual_level_t residual_detector_update(residual_detector_t *detector, float residual)
+{
+    // the statistics start from a residual of 0
+    float diff = residual - detector->mean;
+    detector->mean += RESIDUAL_DETECTOR_ALPHA * diff;
+    detector->var = (1.0f - RESIDUAL_DETECTOR_ALPHA) * (detector->var + RESIDUAL_DETECTOR_ALPHA * diff * diff);
+    detector->samples++;
+    detector->last = residual;
+
+    if (residual > detector->limit)
+        residual = detector->limit;
+    else if (residual < -detector->limit)
+        residual = -detector->limit;
+    detector->cusum += residual - detector->drift;
+    if (detector->cusum <= 0.0f) {
+        residual_detector_reset(detector);
+        return RESIDUAL_NORMAL;
+    }
+
+    enum residual_level_t level = detector->cusum >= detector->alarm ? RESIDUAL_ALARM
+                                : detector->cusum >= detector->warning ? RESIDUAL_WARNING
+                                : RESIDUAL_NORMAL;
+    if (level <= detector->level)
+        return RESIDUAL_NORMAL;
+    detector->level = level;
+    return level;
+}
+
+void residual_detector_reset(residual_detector_t *detector)
+{
+    detector->cusum = 0.0f;
+    detector->level = RESIDUAL_NORMAL;
+}
+
+char *residual_detector_json(char *out, const residual_detector_t *detector)
+{
+    out = fmt_str(out, "\"r\":");
+    out = fmt_fixed(out, detector->last, 4);
+    out = fmt_str(out, ",\"mean\":");
+    out = fmt_fixed(out, detector->mean, 4);
+    out = fmt_str(out, ",\"sd\":");
+    out = fmt_fixed(out, sqrtf(detector->var), 4);
+    out = fmt_str(out, ",\"cusum\":");
+    out = fmt_fixed(out, detector->cusum, 4);
+    out = fmt_str(out, ",\"samples\":");
+    return fmt_int(out, detector->samples);
+}
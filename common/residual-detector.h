@@ -0,0 +1,50 @@
+#ifndef RESIDUAL_DETECTOR_H_
+#define RESIDUAL_DETECTOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Streaming detector of a lasting shift of a residual (model error).
+// A one-sided CUSUM accumulates the part of each residual above the drift
+// allowance and decays on residuals below it: a small but lasting shift
+// builds up to a threshold, while a single outlier does not, and a single
+// good sample does not clear a real degradation. Residuals are clipped
+// to +/-limit, so that an outlier moves the CUSUM by a bounded step. The
+// EWMA mean and variance of the residual are kept for diagnostics. O(1)
+// memory.
+
+#ifdef RESIDUAL_DETECTOR_CONF_ALPHA
+#define RESIDUAL_DETECTOR_ALPHA RESIDUAL_DETECTOR_CONF_ALPHA
+#else
+#define RESIDUAL_DETECTOR_ALPHA 0.1f // weight of the last residual
+#endif
+
+// Levels of the CUSUM, in increasing order
+enum residual_level_t { RESIDUAL_NORMAL, RESIDUAL_WARNING, RESIDUAL_ALARM };
+
+typedef struct {
+    float drift;   // residual allowed without accumulating
+    float limit;   // largest residual taken into account
+    float warning; // CUSUM thresholds
+    float alarm;
+    // state
+    float cusum;
+    float mean;
+    float var;
+    float last;
+    uint32_t samples;
+    uint8_t level; // reached since the CUSUM was last at 0
+} residual_detector_t;
+
+// Adds a residual. Returns the level reached by this sample if it is
+// higher than the previous one, else RESIDUAL_NORMAL: each level is
+// reported once until the CUSUM is back to 0.
+enum residual_level_t residual_detector_update(residual_detector_t *detector, float residual);
+
+// Clears the CUSUM, keeping the statistics
+void residual_detector_reset(residual_detector_t *detector);
+
+// "r":last,"mean":m,"sd":s,"cusum":c,"samples":n into out, returns the end
+char *residual_detector_json(char *out, const residual_detector_t *detector);
+
+#endif /* RESIDUAL_DETECTOR_H_ */
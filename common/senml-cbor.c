@@ -0,0 +1,282 @@
+#include <stdbool.h>
+#include <string.h>
+#include "senml-cbor.h"
+
+// CBOR major types
+#define CBOR_UINT 0
+#define CBOR_NINT 1
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_SIMPLE 7
+
+// additional information of major type 7
+#define CBOR_HALF 25
+#define CBOR_FLOAT 26
+#define CBOR_DOUBLE 27
+
+typedef union {
+    float f;
+    uint32_t u;
+} float_bits_t;
+
+static uint8_t *cbor_head(uint8_t *out, uint8_t major, uint32_t value)
+{
+    major <<= 5;
+    if (value < 24) {
+        *out++ = major | value;
+    } else if (value <= 0xff) {
+        *out++ = major | 24;
+        *out++ = value;
+    } else if (value <= 0xffff) {
+        *out++ = major | 25;
+        *out++ = value >> 8;
+        *out++ = value;
+    } else {
+        *out++ = major | 26;
+        *out++ = value >> 24;
+        *out++ = value >> 16;
+        *out++ = value >> 8;
+        *out++ = value;
+    }
+    return out;
+}
+
+static uint8_t *cbor_int(uint8_t *out, int32_t value)
+{
+    if (value < 0)
+        return cbor_head(out, CBOR_NINT, (uint32_t) (-1 - value));
+    return cbor_head(out, CBOR_UINT, (uint32_t) value);
+}
+
+static uint8_t *cbor_text(uint8_t *out, const char *s)
+{
+    size_t len = strlen(s);
+    out = cbor_head(out, CBOR_TEXT, len);
+    memcpy(out, s, len);
+    return out + len;
+}
+
+// half precision bits of value, false if it is not exactly representable
+static bool float_to_half(float value, uint16_t *half)
+{
+    float_bits_t bits = { .f = value };
+    int32_t exponent = (int32_t) ((bits.u >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits.u & 0x7fffff;
+
+    // normal halfs only, zero is sent as an integer
+    if (exponent <= 0 || exponent >= 31 || (mantissa & 0x1fff) != 0)
+        return false;
+    *half = ((bits.u >> 16) & 0x8000) | (exponent << 10) | (mantissa >> 13);
+    return true;
+}
+
+static float half_to_float(uint16_t half)
+{
+    float_bits_t bits;
+    uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+
+    if (exponent == 0) { // zero and subnormals
+        bits.f = mantissa / 16777216.0f; // 2^-24
+        bits.u |= sign;
+    } else if (exponent == 31) {
+        bits.u = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        bits.u = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    return bits.f;
+}
+
+static uint8_t *cbor_number(uint8_t *out, float value)
+{
+    uint16_t half;
+    float_bits_t bits = { .f = value };
+
+    if (value > -2147483648.0f && value < 2147483648.0f && value == (float) (int32_t) value)
+        return cbor_int(out, (int32_t) value);
+
+    if (float_to_half(value, &half)) {
+        *out++ = (CBOR_SIMPLE << 5) | CBOR_HALF;
+        *out++ = half >> 8;
+        *out++ = half;
+        return out;
+    }
+
+    *out++ = (CBOR_SIMPLE << 5) | CBOR_FLOAT;
+    *out++ = bits.u >> 24;
+    *out++ = bits.u >> 16;
+    *out++ = bits.u >> 8;
+    *out++ = bits.u;
+    return out;
+}
+
+uint8_t *senml_cbor_pack(uint8_t *out, uint8_t n_records)
+{
+    return cbor_head(out, CBOR_ARRAY, n_records);
+}
+
+uint8_t *senml_cbor_record(uint8_t *out, const char *base_name, const char *name, float value)
+{
+    out = cbor_head(out, CBOR_MAP, 1 + (base_name != NULL) + (name != NULL));
+    if (base_name != NULL) {
+        out = cbor_int(out, SENML_CBOR_BASE_NAME);
+        out = cbor_text(out, base_name);
+    }
+    if (name != NULL) {
+        out = cbor_int(out, SENML_CBOR_NAME);
+        out = cbor_text(out, name);
+    }
+    out = cbor_int(out, SENML_CBOR_VALUE);
+    return cbor_number(out, value);
+}
+
+// Decoder state: the input is consumed from in to end
+typedef struct {
+    const uint8_t *in;
+    const uint8_t *end;
+} cbor_reader_t;
+
+static bool cbor_read_head(cbor_reader_t *r, uint8_t *major, uint8_t *info, uint32_t *value)
+{
+    if (r->in >= r->end)
+        return false;
+    *major = *r->in >> 5;
+    *info = *r->in & 0x1f;
+    r->in++;
+
+    uint8_t n = *info < 24 ? 0 : *info == 24 ? 1 : *info == 25 ? 2 : *info == 26 ? 4 : 8;
+    if (*info > 27 || r->end - r->in < n)
+        return false;
+
+    *value = *info < 24 ? *info : 0;
+    for (uint8_t i = 0; i < n; i++) {
+        if (n == 8 && i < 4 && *major != CBOR_SIMPLE && *r->in != 0)
+            return false; // 64 bit integers and lengths are not used
+        *value = (*value << 8) | *r->in++;
+    }
+    return true;
+}
+
+static bool cbor_read_int(cbor_reader_t *r, int32_t *value)
+{
+    uint8_t major, info;
+    uint32_t v;
+
+    if (!cbor_read_head(r, &major, &info, &v) || v > INT32_MAX)
+        return false;
+    if (major == CBOR_UINT)
+        *value = (int32_t) v;
+    else if (major == CBOR_NINT)
+        *value = -1 - (int32_t) v;
+    else
+        return false;
+    return true;
+}
+
+static bool cbor_read_text(cbor_reader_t *r, const char **s, uint8_t *len)
+{
+    uint8_t major, info;
+    uint32_t n;
+
+    if (!cbor_read_head(r, &major, &info, &n) || major != CBOR_TEXT
+        || n > 0xff || r->end - r->in < (int32_t) n)
+        return false;
+    *s = (const char *) r->in;
+    *len = n;
+    r->in += n;
+    return true;
+}
+
+static bool cbor_read_number(cbor_reader_t *r, float *value)
+{
+    uint8_t major, info;
+    uint32_t v;
+    float_bits_t bits;
+
+    if (!cbor_read_head(r, &major, &info, &v))
+        return false;
+
+    if (major == CBOR_UINT) {
+        *value = (float) v;
+    } else if (major == CBOR_NINT) {
+        *value = -1.0f - (float) v;
+    } else if (major == CBOR_SIMPLE && info == CBOR_HALF) {
+        *value = half_to_float(v);
+    } else if (major == CBOR_SIMPLE && info == CBOR_FLOAT) {
+        bits.u = v;
+        *value = bits.f;
+    } else {
+        return false; // doubles are never sent by the nodes
+    }
+    return true;
+}
+
+int senml_cbor_decode(const uint8_t *in, int len, senml_cbor_record_fn record_fn)
+{
+    cbor_reader_t r = { in, in + len };
+    uint8_t major, info;
+    uint32_t n_records, n_fields;
+    const char *base_name = "";
+    uint8_t base_name_len = 0;
+
+    if (!cbor_read_head(&r, &major, &info, &n_records) || major != CBOR_ARRAY)
+        return -1;
+
+    for (uint32_t i = 0; i < n_records; i++) {
+        const char *name = "";
+        uint8_t name_len = 0;
+        bool has_value = false;
+        float value = 0.0f;
+
+        if (!cbor_read_head(&r, &major, &info, &n_fields) || major != CBOR_MAP)
+            return -1;
+
+        for (uint32_t f = 0; f < n_fields; f++) {
+            int32_t label;
+            if (!cbor_read_int(&r, &label))
+                return -1;
+
+            bool ok;
+            switch (label) {
+                case SENML_CBOR_BASE_NAME:
+                    ok = cbor_read_text(&r, &base_name, &base_name_len);
+                    break;
+                case SENML_CBOR_NAME:
+                    ok = cbor_read_text(&r, &name, &name_len);
+                    break;
+                case SENML_CBOR_VALUE:
+                    ok = has_value = cbor_read_number(&r, &value);
+                    break;
+                default:
+                    ok = false; // other SenML fields are never sent by the nodes
+                    break;
+            }
+            if (!ok)
+                return -1;
+        }
+
+        if (has_value)
+            record_fn(base_name, base_name_len, name, name_len, value);
+    }
+    return n_records;
+}
+
+int senml_cbor_select_format(coap_message_t *request, int32_t *offset, unsigned int *notify_format)
+{
+    unsigned int accept;
+    uint32_t observe;
+
+    if (offset == NULL) // notification
+        return *notify_format;
+
+    if (!coap_get_header_accept(request, &accept))
+        return APPLICATION_JSON;
+    if (accept != APPLICATION_JSON && accept != SENML_CBOR_CONTENT_FORMAT)
+        return -1;
+
+    if (coap_get_header_observe(request, &observe) && observe == 0)
+        *notify_format = accept;
+    return accept;
+}
@@ -0,0 +1,39 @@
+#ifndef SENML_CBOR_H_
+#define SENML_CBOR_H_
+
+#include <stdint.h>
+#include "coap-engine.h"
+
+// SenML-CBOR (RFC 8428) payloads, the compact alternative to the JSON
+// ones, served when a client asks for it with the CoAP Accept option.
+// A resource is one pack: the first record carries the base name, the
+// others only the field name. Multi-field resources use "<resource>/" as
+// base name ("weather/" + "irr"), single value ones the resource name.
+
+#define SENML_CBOR_CONTENT_FORMAT 112 // application/senml+cbor
+
+// SenML labels
+#define SENML_CBOR_BASE_NAME -2
+#define SENML_CBOR_NAME 0
+#define SENML_CBOR_VALUE 2
+
+// Encoder, same chaining as fixed-fmt.h: returns the end of the output.
+// Values use the smallest exact encoding: integer, half or single float.
+uint8_t *senml_cbor_pack(uint8_t *out, uint8_t n_records);
+uint8_t *senml_cbor_record(uint8_t *out, const char *base_name, const char *name, float value);
+
+// Decoder: calls record_fn for every record with a numeric value.
+// Names point into the payload and are not NUL-terminated.
+// Returns the number of records, -1 if the payload is malformed.
+typedef void (*senml_cbor_record_fn)(const char *base_name, uint8_t base_name_len,
+                                     const char *name, uint8_t name_len, float value);
+int senml_cbor_decode(const uint8_t *in, int len, senml_cbor_record_fn record_fn);
+
+// Content format of a GET response: APPLICATION_JSON (default),
+// SENML_CBOR_CONTENT_FORMAT or -1 for an unsupported Accept option.
+// Notifications are built by Contiki from a request without options
+// (offset == NULL), so they use *notify_format, set by the last observe
+// registration that carried an Accept option.
+int senml_cbor_select_format(coap_message_t *request, int32_t *offset, unsigned int *notify_format);
+
+#endif /* SENML_CBOR_H_ */
@@ -0,0 +1,162 @@
+#include <string.h>
+#include "task-sched.h"
+
+static struct process *sched_process;
+static struct etimer timer;
+static task_t *tasks[TASK_SCHED_MAX_TASKS];
+static uint8_t n_tasks = 0;
+static bool night = false;
+static uint32_t wakeups = 0;
+static unsigned long started = 0;
+
+static clock_time_t task_interval(const task_t *task, bool at_night)
+{
+    if (at_night && task->night_stretch > 1)
+        return task->interval * task->night_stretch;
+    return task->interval;
+}
+
+// Timer to the earliest due task, set in the context of the process
+// (the etimer would otherwise post to the caller)
+static void arm(void)
+{
+    if (n_tasks == 0)
+        return;
+
+    clock_time_t now = clock_time();
+    clock_time_t next = tasks[0]->due;
+    for (uint8_t i = 1; i < n_tasks; i++)
+        if (CLOCK_LT(tasks[i]->due, next))
+            next = tasks[i]->due;
+
+    PROCESS_CONTEXT_BEGIN(sched_process);
+    etimer_set(&timer, CLOCK_LT(now, next) ? next - now : 0);
+    PROCESS_CONTEXT_END(sched_process);
+}
+
+// Run no later than the end of the new interval
+static void bring_forward(task_t *task, clock_time_t now)
+{
+    clock_time_t due = now + task_interval(task, night);
+    if (CLOCK_LT(due, task->due))
+        task->due = due;
+}
+
+void task_sched_init(struct process *process)
+{
+    sched_process = process;
+    started = clock_seconds();
+}
+
+void task_sched_add(task_t *task)
+{
+    if (n_tasks == TASK_SCHED_MAX_TASKS || task->interval == 0)
+        return;
+
+    task->due = clock_time() + task_interval(task, night);
+    tasks[n_tasks++] = task;
+    arm();
+}
+
+bool task_sched_expired(void *data)
+{
+    return data == &timer;
+}
+
+void task_sched_run(void)
+{
+    clock_time_t now = clock_time();
+
+    wakeups++;
+    for (uint8_t i = 0; i < n_tasks; i++) {
+        task_t *task = tasks[i];
+        if (CLOCK_LT(now + TASK_SCHED_SLACK, task->due))
+            continue;
+        task->runs++;
+        task->run(); // can change its own interval
+        task->due = now + task_interval(task, night);
+    }
+    arm();
+}
+
+task_t *task_sched_task(uint8_t i)
+{
+    return i < n_tasks ? tasks[i] : NULL;
+}
+
+task_t *task_sched_find(const char *name, int len)
+{
+    for (uint8_t i = 0; i < n_tasks; i++)
+        if (len == (int) strlen(tasks[i]->name) && strncmp(name, tasks[i]->name, len) == 0)
+            return tasks[i];
+    return NULL;
+}
+
+void task_sched_set_interval(task_t *task, clock_time_t interval, uint8_t night_stretch)
+{
+    if (interval == 0)
+        return;
+
+    task->interval = interval;
+    task->night_stretch = night_stretch;
+    bring_forward(task, clock_time());
+    arm();
+}
+
+clock_time_t task_sched_longest_interval(const task_t *task)
+{
+    return task_interval(task, true);
+}
+
+void task_sched_set_night(bool at_night)
+{
+    if (at_night == night)
+        return;
+
+    night = at_night;
+    if (!night) {
+        clock_time_t now = clock_time();
+        for (uint8_t i = 0; i < n_tasks; i++)
+            bring_forward(tasks[i], now);
+        arm();
+    }
+}
+
+bool task_sched_is_night(void)
+{
+    return night;
+}
+
+// Runs the scheduler for an hour with all the tasks starting together
+uint32_t task_sched_expected_wakeups(void)
+{
+    const uint32_t hour = 3600UL * CLOCK_SECOND;
+    uint32_t due[TASK_SCHED_MAX_TASKS] = { 0 };
+    uint32_t t = 0, n = 0;
+
+    if (n_tasks == 0)
+        return 0;
+
+    while (t < hour) {
+        uint32_t next = UINT32_MAX;
+        n++;
+        for (uint8_t i = 0; i < n_tasks; i++) {
+            if (due[i] <= t + TASK_SCHED_SLACK)
+                due[i] = t + task_interval(tasks[i], night);
+            if (due[i] < next)
+                next = due[i];
+        }
+        t = next;
+    }
+    return n;
+}
+
+uint32_t task_sched_wakeups(void)
+{
+    return wakeups;
+}
+
+unsigned long task_sched_seconds(void)
+{
+    return clock_seconds() - started;
+}
@@ -0,0 +1,70 @@
+#ifndef TASK_SCHED_H_
+#define TASK_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "contiki.h"
+
+// Periodic tasks of a process on a single etimer.
+// A wakeup runs every task due within TASK_SCHED_SLACK of it, and each
+// task run is rescheduled from the wakeup: tasks that ran together stay
+// aligned and share their wakeups from then on. At night the intervals
+// are multiplied by the night stretch of each task, so that the CPU
+// stays longer in low power mode.
+
+#ifdef TASK_SCHED_CONF_SLACK
+#define TASK_SCHED_SLACK TASK_SCHED_CONF_SLACK
+#else
+#define TASK_SCHED_SLACK (CLOCK_SECOND * 2) // how early a task can run
+#endif
+
+#ifdef TASK_SCHED_CONF_MAX_TASKS
+#define TASK_SCHED_MAX_TASKS TASK_SCHED_CONF_MAX_TASKS
+#else
+#define TASK_SCHED_MAX_TASKS 8
+#endif
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+    clock_time_t interval;
+    uint8_t night_stretch; // interval multiplier at night, 0 or 1: none
+    // state
+    clock_time_t due;
+    uint32_t runs;
+} task_t;
+
+// Tasks run from process, in the order they are added
+void task_sched_init(struct process *process);
+void task_sched_add(task_t *task);
+
+// True if a PROCESS_EVENT_TIMER of the process is the scheduler one:
+// then task_sched_run() runs the tasks that are due
+bool task_sched_expired(void *data);
+void task_sched_run(void);
+
+// i-th task, NULL past the last one
+task_t *task_sched_task(uint8_t i);
+task_t *task_sched_find(const char *name, int len);
+
+// Changes the interval of a task, from any process. The next run is
+// brought forward if the new interval ends earlier.
+void task_sched_set_interval(task_t *task, clock_time_t interval, uint8_t night_stretch);
+
+// Longest gap between two runs of task: its interval, stretched
+clock_time_t task_sched_longest_interval(const task_t *task);
+
+// Night: stretched intervals, from the next run of each task (on the way
+// back to day the stretched runs are brought forward)
+void task_sched_set_night(bool night);
+bool task_sched_is_night(void);
+
+// Wakeups per hour with the current intervals, as the scheduler would
+// align them
+uint32_t task_sched_expected_wakeups(void);
+
+// Wakeups and uptime of the scheduler, for the measured rate
+uint32_t task_sched_wakeups(void);
+unsigned long task_sched_seconds(void);
+
+#endif /* TASK_SCHED_H_ */
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+# Offline pruning of the emlearn solar power model.
+#
+# Reads the float header written by the notebook (../solar-power-model.h),
+# removes dead neurons and writes ../solar-power-model-sparse.h, evaluated
+# on the node by sparse-net.h.
+#
+# A ReLU neuron is dead when interval bound propagation over INPUT_DOMAIN
+# proves its pre-activation is never positive (typically a zero bias with
+# only negative input weights), or when all its outgoing weights are zero.
+# Removing it does not change the output anywhere in the domain: the script
+# checks the pruned model against the dense one and fails on any mismatch.
+# Outside of it the pruned model may differ: the node keeps the model
+# inputs within the weather range of resources/res-weather.c, inside it.
+#
+# Weights below --threshold are dropped as well; a layer is stored in CSR
+# form (row offsets + column indices) when that is smaller than dense.
+
+import argparse
+import itertools
+import sys
+
+from quantize_model import NAME, parse_float_model, float_forward
+
+# Physical input domain: out_temperature, module_temperature, irradiation
+INPUT_DOMAIN = [
+    (0.0, 100.0),
+    (0.0, 100.0),
+    (0.0, 2.0),
+]
+CHECK_STEPS = 15
+MAX_ERROR = 1e-3  # in W, pruning dead neurons must be exact
+
+
+def interval_bounds(layers, domain):
+    lo = [d[0] for d in domain]
+    hi = [d[1] for d in domain]
+    bounds = []
+    for layer in layers:
+        n_in, n_out, w = layer['n_inputs'], layer['n_outputs'], layer['weights']
+        new_lo, new_hi = [], []
+        for o in range(n_out):
+            a = b = layer['biases'][o]
+            for i in range(n_in):
+                wi = w[i * n_out + o]
+                if wi >= 0.0:
+                    a, b = a + wi * lo[i], b + wi * hi[i]
+                else:
+                    a, b = a + wi * hi[i], b + wi * lo[i]
+            if layer['activation'] == 'Relu':
+                a, b = max(a, 0.0), max(b, 0.0)
+            new_lo.append(a)
+            new_hi.append(b)
+        bounds.append(new_hi)
+        lo, hi = new_lo, new_hi
+    return bounds
+
+
+def remove_neurons(layers, n, keep):
+    # drop outputs of layer n and the matching inputs of layer n + 1
+    layer, nxt = layers[n], layers[n + 1]
+    n_in, n_out = layer['n_inputs'], layer['n_outputs']
+    layer['weights'] = [layer['weights'][i * n_out + o] for i in range(n_in) for o in keep]
+    layer['biases'] = [layer['biases'][o] for o in keep]
+    layer['n_outputs'] = len(keep)
+    m_out = nxt['n_outputs']
+    nxt['weights'] = [nxt['weights'][i * m_out + o] for i in keep for o in range(m_out)]
+    nxt['n_inputs'] = len(keep)
+
+
+def prune_dead_neurons(layers, domain=INPUT_DOMAIN):
+    layers = [dict(l) for l in layers]
+    removed = []
+    for n in range(len(layers) - 1):
+        if layers[n]['activation'] != 'Relu':
+            removed.append(0)
+            continue
+        upper = interval_bounds(layers, domain)[n]
+        nxt = layers[n + 1]
+        m_out = nxt['n_outputs']
+        keep = [o for o in range(layers[n]['n_outputs'])
+                if upper[o] > 0.0 and any(nxt['weights'][o * m_out + k] != 0.0 for k in range(m_out))]
+        removed.append(layers[n]['n_outputs'] - len(keep))
+        remove_neurons(layers, n, keep)
+    return layers, removed
+
+
+def drop_small_weights(layers, threshold):
+    for layer in layers:
+        layer['weights'] = [0.0 if abs(v) < threshold else v for v in layer['weights']]
+    return layers
+
+
+def to_rows(layer):
+    # [n_inputs][n_outputs] -> one row of (column, weight) per neuron
+    n_in, n_out, w = layer['n_inputs'], layer['n_outputs'], layer['weights']
+    return [[(i, w[i * n_out + o]) for i in range(n_in) if w[i * n_out + o] != 0.0] for o in range(n_out)]
+
+
+def layer_bytes(layer, csr):
+    if not csr:
+        return 4 * (layer['n_inputs'] * layer['n_outputs'] + layer['n_outputs'])
+    nnz = sum(len(r) for r in to_rows(layer))
+    return 5 * nnz + 2 * (layer['n_outputs'] + 1) + 4 * layer['n_outputs']
+
+
+def c_array(ctype, name, values, fmt):
+    return 'static const %s %s_%s[%d] = { %s };\n' % (
+        ctype, NAME, name, len(values), ', '.join(fmt % v for v in values))
+
+
+def write_header(path, layers, removed):
+    n_layers = len(layers)
+    buf_len = max(l['n_outputs'] for l in layers)
+    out = ['// Generated by ML-expected-solar-power/prune_model.py, do not edit.\n',
+           '// Dead neurons removed per layer: %s\n' % ', '.join(str(r) for r in removed),
+           '#include "sparse-net.h"\n']
+    entries = []
+    for n, l in enumerate(layers):
+        rows = to_rows(l)
+        csr = layer_bytes(l, True) < layer_bytes(l, False)
+        out.append(c_array('float', 'sparse_layer_%d_biases' % n, l['biases'], '%ff'))
+        if csr:
+            row_ptr = [0]
+            for r in rows:
+                row_ptr.append(row_ptr[-1] + len(r))
+            out.append(c_array('float', 'sparse_layer_%d_weights' % n, [w for r in rows for _, w in r], '%ff'))
+            out.append(c_array('uint16_t', 'sparse_layer_%d_row_ptr' % n, row_ptr, '%d'))
+            out.append(c_array('uint8_t', 'sparse_layer_%d_col_idx' % n, [i for r in rows for i, _ in r], '%d'))
+            ptrs = '%s_sparse_layer_%d_row_ptr, %s_sparse_layer_%d_col_idx' % (NAME, n, NAME, n)
+        else:
+            dense = [l['weights'][i * l['n_outputs'] + o] for o in range(l['n_outputs']) for i in range(l['n_inputs'])]
+            out.append(c_array('float', 'sparse_layer_%d_weights' % n, dense, '%ff'))
+            ptrs = 'NULL, NULL'
+        entries.append('{ %d, %d, %s_sparse_layer_%d_weights, %s, %s_sparse_layer_%d_biases, SparseNetActivation%s }' % (
+            l['n_outputs'], l['n_inputs'], NAME, n, ptrs, NAME, n, l['activation']))
+    out.append('static float %s_sparse_buf1[%d];\n' % (NAME, buf_len))
+    out.append('static float %s_sparse_buf2[%d];\n' % (NAME, buf_len))
+    out.append('static const SparseNetLayer %s_sparse_layers[%d] = { \n' % (NAME, n_layers))
+    out.append(', \n'.join(entries) + ' };\n')
+    out.append('static const SparseNet %s_sparse = { %d, %s_sparse_layers, %s_sparse_buf1, %s_sparse_buf2, %d };\n' % (
+        NAME, n_layers, NAME, NAME, NAME, buf_len))
+    out.append('''
+    float
+    %s_sparse_regress1(const float *features, int32_t n_features)
+    {
+        return sparse_net_regress1(&%s_sparse, features, n_features);
+    }
+''' % (NAME, NAME))
+    with open(path, 'w') as f:
+        f.write(''.join(out))
+
+
+def macs(layers):
+    return sum(sum(len(r) for r in to_rows(l)) for l in layers)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Prune dead neurons of the solar power model')
+    parser.add_argument('--input', default='../solar-power-model.h')
+    parser.add_argument('--output', default='../solar-power-model-sparse.h')
+    parser.add_argument('--threshold', type=float, default=0.0,
+                        help='also drop weights smaller than this (changes the output)')
+    parser.add_argument('--max-error', type=float, default=MAX_ERROR)
+    args = parser.parse_args()
+
+    dense = parse_float_model(args.input)
+    pruned, removed = prune_dead_neurons(dense)
+    if args.threshold > 0.0:
+        pruned = drop_small_weights(pruned, args.threshold)
+
+    # host-side equivalence check against the dense model
+    max_error = 0.0
+    axes = [[lo + (hi - lo) * k / (CHECK_STEPS - 1) for k in range(CHECK_STEPS)] for lo, hi in INPUT_DOMAIN]
+    for x in itertools.product(*axes):
+        max_error = max(max_error, abs(float_forward(dense, x) - float_forward(pruned, x)))
+
+    print('Dead neurons removed per layer:', removed)
+    print('MACs per prediction: %d -> %d' % (macs(dense), macs(pruned)))
+    print('Model bytes: %d -> %d' % (
+        sum(layer_bytes(l, False) for l in dense),
+        sum(min(layer_bytes(l, True), layer_bytes(l, False)) for l in pruned)))
+    print('Max error vs dense model: %.6f W' % max_error)
+
+    if max_error > args.max_error:
+        print('Pruned model differs from the dense one, header not written')
+        return 1
+
+    write_header(args.output, pruned, removed)
+    print('Wrote pruned model to', args.output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
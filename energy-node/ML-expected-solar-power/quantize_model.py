@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+# Post-training quantization of the emlearn solar power model.
+#
+# Reads the float header written by the notebook (../solar-power-model.h),
+# quantizes it to int8 weights / int16 activations with one scale per layer
+# (plus one scale per input feature)
+# and writes ../solar-power-model-q8.h, evaluated on the node by q8-net.h.
+# Dead neurons are removed first (see prune_model.py), which is exact.
+#
+# The quantized network is simulated here with the same integer arithmetic
+# as the C kernel and compared to the float model over the weather input
+# range: the script fails if the error exceeds MAX_ERROR.
+#
+# With --binary the model is written as an image for the /model resource
+# of the node instead (see the image layout in q8-net.h), to replace the
+# built-in model without a new firmware.
+
+import argparse
+import itertools
+import re
+import struct
+import sys
+import zlib
+
+NAME = 'solar_power_prediction'
+
+# Weather input range (see resources/res-weather.c, update_weather() keeps
+# the random walk within it), with some headroom
+INPUT_RANGES = [
+    (15.0, 40.0),   # out_temperature
+    (10.0, 70.0),   # module_temperature
+    (0.0, 1.6),     # irradiation
+]
+INPUT_HEADROOM = 1.25
+ACTIVATION_HEADROOM = 1.25
+GRID_STEPS = 12
+CHECK_STEPS = 21
+
+MAX_POWER = 3000.0
+MAX_ERROR = 0.02 * MAX_POWER  # in W, well below MAX_OFFSET_PREDICTION
+
+INT8_MAX = 127
+INT16_MAX = 32767
+MULT_BITS = 30
+
+IMAGE_FORMAT = 1
+# test vector of the image, checked by the node before it runs the model
+TEST_INPUT = [(lo + hi) / 2.0 for lo, hi in INPUT_RANGES]
+
+
+def parse_float_model(path):
+    with open(path) as f:
+        src = f.read()
+
+    arrays = {}
+    for m in re.finditer(r'static const float (\w+)\[(\d+)\] = \{([^}]*)\};', src):
+        values = [float(v.strip().rstrip('f')) for v in m.group(3).split(',') if v.strip()]
+        assert len(values) == int(m.group(2)), m.group(1)
+        arrays[m.group(1)] = values
+
+    layers = []
+    for m in re.finditer(r'\{ (\d+), (\d+), (\w+), (\w+), EmlNetActivation(\w+) \}', src):
+        layers.append({
+            'n_outputs': int(m.group(1)),
+            'n_inputs': int(m.group(2)),
+            'weights': arrays[m.group(3)],  # emlearn layout: [n_inputs][n_outputs]
+            'biases': arrays[m.group(4)],
+            'activation': m.group(5),
+        })
+    if not layers:
+        raise ValueError('no layers found in %s' % path)
+    return layers
+
+
+def float_forward(layers, x, trace=None):
+    for n, layer in enumerate(layers):
+        n_in, n_out, w = layer['n_inputs'], layer['n_outputs'], layer['weights']
+        y = []
+        for o in range(n_out):
+            s = layer['biases'][o]
+            for i in range(n_in):
+                s += x[i] * w[i * n_out + o]
+            if layer['activation'] == 'Relu' and s < 0.0:
+                s = 0.0
+            y.append(s)
+        if trace is not None:
+            trace[n] = max(trace[n], max(abs(v) for v in y))
+        x = y
+    return x[0]
+
+
+def input_grid(steps):
+    axes = [[lo + (hi - lo) * k / (steps - 1) for k in range(steps)] for lo, hi in INPUT_RANGES]
+    return list(itertools.product(*axes))
+
+
+def quantize_multiplier(m):
+    # m ~= mult * 2^-shift, with mult in [2^(MULT_BITS-1), 2^MULT_BITS)
+    shift = 0
+    while m < 0.5 and shift < 62:
+        m *= 2.0
+        shift += 1
+    mult = int(round(m * (1 << MULT_BITS)))
+    if mult == (1 << MULT_BITS):
+        mult //= 2
+        shift -= 1
+    return mult, shift + MULT_BITS
+
+
+def quantize(layers, samples):
+    trace = [0.0] * len(layers)
+    for x in samples:
+        float_forward(layers, x, trace)
+
+    # One scale per input feature, folded into the first layer weights so
+    # that temperatures and irradiation use the full int16 range
+    input_scales = [max(abs(lo), abs(hi)) * INPUT_HEADROOM / INT16_MAX for lo, hi in INPUT_RANGES]
+    in_scale = 1.0
+    qlayers = []
+    for n, layer in enumerate(layers):
+        n_in, n_out, w = layer['n_inputs'], layer['n_outputs'], layer['weights']
+        if n == 0:
+            w = [w[i * n_out + o] * input_scales[i] for i in range(n_in) for o in range(n_out)]
+        w_scale = max(abs(v) for v in w) / INT8_MAX
+        acc_scale = w_scale * in_scale
+        # transpose to [n_outputs][n_inputs]: one contiguous row per neuron
+        qw = [int(round(w[i * n_out + o] / w_scale)) for o in range(n_out) for i in range(n_in)]
+        qb = [int(round(b / acc_scale)) for b in layer['biases']]
+        last = (n == len(layers) - 1)
+        if last:
+            out_scale, mult, shift = acc_scale, 0, 0
+        else:
+            out_scale = trace[n] * ACTIVATION_HEADROOM / INT16_MAX
+            mult, shift = quantize_multiplier(acc_scale / out_scale)
+        qlayers.append({
+            'n_outputs': n_out,
+            'n_inputs': n_in,
+            'weights': qw,
+            'biases': qb,
+            'multiplier': mult,
+            'shift': shift,
+            'activation': layer['activation'],
+            'w_scale': w_scale,
+        })
+        in_scale = out_scale
+    return qlayers, input_scales, in_scale
+
+
+def f32(v):
+    return struct.unpack('<f', struct.pack('<f', v))[0]
+
+
+def q8_forward(qlayers, input_scales, output_scale, x):
+    # Integer model of q8_net_regress1() in q8-net.h, with the float32
+    # input quantization of q8_net_quantize()
+    a = []
+    for v, scale in zip(x, input_scales):
+        t = f32(f32(v) * f32(1.0 / scale))
+        q = int(f32(t + 0.5)) if t >= 0.0 else int(f32(t - 0.5))
+        a.append(max(-INT16_MAX, min(INT16_MAX, q)))
+    for n, layer in enumerate(qlayers):
+        n_in, n_out = layer['n_inputs'], layer['n_outputs']
+        last = (n == len(qlayers) - 1)
+        y = []
+        for o in range(n_out):
+            acc = layer['biases'][o]
+            row = layer['weights'][o * n_in:(o + 1) * n_in]
+            for i in range(n_in):
+                acc += row[i] * a[i]
+            if layer['activation'] == 'Relu' and acc < 0:
+                acc = 0
+            if last:
+                y.append(acc)
+                continue
+            shift = layer['shift']
+            r = (acc * layer['multiplier'] + (1 << (shift - 1))) >> shift
+            y.append(max(-INT16_MAX, min(INT16_MAX, r)))
+        a = y
+    return a[0] * output_scale
+
+
+def c_array(ctype, name, values, fmt):
+    return 'static const %s %s_%s[%d] = { %s };\n' % (
+        ctype, NAME, name, len(values), ', '.join(fmt % v for v in values))
+
+
+def write_header(path, qlayers, input_scales, output_scale, max_error):
+    n_layers = len(qlayers)
+    buf_len = max(l['n_outputs'] for l in qlayers)
+    out = ['// Generated by ML-expected-solar-power/quantize_model.py, do not edit.\n',
+           '// int8 weights, int16 activations, one scale per layer.\n',
+           '// Max error vs float model on the weather range: %.3f W\n' % max_error,
+           '#include "q8-net.h"\n']
+    for n, l in enumerate(qlayers):
+        out.append(c_array('int32_t', 'q8_layer_%d_biases' % n, l['biases'], '%d'))
+        out.append(c_array('int8_t', 'q8_layer_%d_weights' % n, l['weights'], '%d'))
+    out.append('static int16_t %s_q8_buf1[%d];\n' % (NAME, buf_len))
+    out.append('static int16_t %s_q8_buf2[%d];\n' % (NAME, buf_len))
+    # batch activations go by pairs of neurons, see q8_net_regress()
+    batch_len = (max(buf_len, qlayers[0]['n_inputs']) + 1) // 2 * 2
+    out.append('static int16_t %s_q8_batch1[Q8_NET_BATCH * %d];\n' % (NAME, batch_len))
+    out.append('static int16_t %s_q8_batch2[Q8_NET_BATCH * %d];\n' % (NAME, batch_len))
+    out.append('static const Q8NetLayer %s_q8_layers[%d] = { \n' % (NAME, n_layers))
+    rows = []
+    for n, l in enumerate(qlayers):
+        rows.append('{ %d, %d, %s_q8_layer_%d_weights, %s_q8_layer_%d_biases, %d, %d, Q8NetActivation%s }' % (
+            l['n_outputs'], l['n_inputs'], NAME, n, NAME, n, l['multiplier'], l['shift'], l['activation']))
+    out.append(', \n'.join(rows) + ' };\n')
+    out.append('static const float %s_q8_input_scales[%d] = { %s };\n' % (
+        NAME, len(input_scales), ', '.join('%.9ef' % (1.0 / s) for s in input_scales)))
+    out.append('static const Q8Net %s_q8 = { %d, %s_q8_layers, %s_q8_buf1, %s_q8_buf2, %d, %s_q8_input_scales, %.9ef };\n' % (
+        NAME, n_layers, NAME, NAME, NAME, buf_len, NAME, output_scale))
+    out.append('''
+    float
+    %s_q8_regress1(const float *features, int32_t n_features)
+    {
+        return q8_net_regress1(&%s_q8, features, n_features);
+    }
+
+    int32_t
+    %s_q8_regress(const float *features, int32_t n_features, int32_t n_samples, float *outputs)
+    {
+        return q8_net_regress(&%s_q8, features, n_features, n_samples, %s_q8_batch1, %s_q8_batch2, outputs);
+    }
+''' % (NAME, NAME, NAME, NAME, NAME, NAME))
+    with open(path, 'w') as f:
+        f.write(''.join(out))
+
+
+def write_image(path, qlayers, input_scales, output_scale, revision):
+    n_inputs = qlayers[0]['n_inputs']
+    test_output = q8_forward(qlayers, input_scales, output_scale, TEST_INPUT)
+    body = struct.pack('<%df' % n_inputs, *(1.0 / s for s in input_scales))
+    body += struct.pack('<%df' % (n_inputs + 1), *(TEST_INPUT + [test_output]))
+    for l in qlayers:
+        body += struct.pack('<HHiBBH', l['n_outputs'], l['n_inputs'], l['multiplier'], l['shift'],
+                            1 if l['activation'] == 'Relu' else 0, 0)
+    for l in qlayers:
+        body += struct.pack('<%di' % len(l['biases']), *l['biases'])
+        body += struct.pack('<%db' % len(l['weights']), *l['weights'])
+        body += bytes(-len(l['weights']) % 4)
+
+    size = 20 + len(body) + 4
+    image = struct.pack('<3sBIIBBHf', b'Q8M', IMAGE_FORMAT, revision, size, len(qlayers), n_inputs, 0, output_scale)
+    image += body
+    image += struct.pack('<I', zlib.crc32(image) & 0xffffffff)
+    with open(path, 'wb') as f:
+        f.write(image)
+    return size, test_output
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Quantize the solar power model to int8')
+    parser.add_argument('--input', default='../solar-power-model.h')
+    parser.add_argument('--output', default='../solar-power-model-q8.h')
+    parser.add_argument('--max-error', type=float, default=MAX_ERROR)
+    parser.add_argument('--no-prune', action='store_true', help='keep dead neurons')
+    parser.add_argument('--binary', metavar='PATH', help='write a model image for the node instead of the header')
+    parser.add_argument('--revision', type=int, default=1, help='revision of the model image')
+    args = parser.parse_args()
+
+    layers = parse_float_model(args.input)
+    float_bytes = sum(4 * (len(l['weights']) + len(l['biases'])) for l in layers)
+    if not args.no_prune:
+        from prune_model import prune_dead_neurons
+        layers, removed = prune_dead_neurons(layers)
+        print('Dead neurons removed per layer:', removed)
+    calibration = input_grid(GRID_STEPS)
+    qlayers, input_scales, output_scale = quantize(layers, calibration)
+
+    # check on a finer grid than the calibration one
+    max_error = 0.0
+    sum_error = 0.0
+    worst = None
+    checks = input_grid(CHECK_STEPS)
+    for x in checks:
+        ref = float_forward(layers, x)
+        got = q8_forward(qlayers, input_scales, output_scale, x)
+        sum_error += abs(ref - got)
+        if abs(ref - got) > max_error:
+            max_error, worst = abs(ref - got), x
+
+    q8_bytes = sum(len(l['weights']) + 4 * len(l['biases']) for l in qlayers)
+    print('Float model: %d bytes, quantized model: %d bytes' % (float_bytes, q8_bytes))
+    print('Mean error: %.3f W' % (sum_error / len(checks)))
+    print('Max error: %.3f W at %s' % (max_error, ', '.join('%.2f' % v for v in worst)))
+
+    if max_error > args.max_error:
+        print('Quantization error above %.1f W, header not written' % args.max_error)
+        return 1
+
+    if args.binary:
+        size, test_output = write_image(args.binary, qlayers, input_scales, output_scale, args.revision)
+        print('Wrote model image revision %d (%d bytes, test output %.3f W) to %s' % (
+            args.revision, size, test_output, args.binary))
+        return 0
+
+    write_header(args.output, qlayers, input_scales, output_scale, max_error)
+    print('Wrote quantized model to', args.output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
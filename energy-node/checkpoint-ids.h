@@ -0,0 +1,8 @@
+#ifndef CHECKPOINT_IDS_H_
+#define CHECKPOINT_IDS_H_
+
+// Ids of the energy node checkpoint items, see checkpoint.h. The records
+// in the log are matched by id: append new items, never renumber.
+enum checkpoint_id_t { CKPT_BATTERY, CKPT_RELAY, CKPT_PREDICTIONS, CKPT_MODEL, CKPT_CALIBRATION };
+
+#endif /* CHECKPOINT_IDS_H_ */
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "node-bench.h"
+#include "fixed-fmt.h"
+
+// Host benchmark of the energy node hot paths: make bench (TARGET=native)
+
+// external resources
+float solar_power_predict();
+float solar_power_evaluate();
+void solar_power_evaluate_batch(const float *inputs, uint8_t n, float *predictions);
+void weather_extrapolate(float *inputs, uint8_t n, clock_time_t step);
+void update_gen_power();
+void weather_json_string(char* buffer);
+void battery_json_string(char* buffer);
+void gen_power_json_string(char* buffer);
+void relay_json_string(char* buffer);
+void antiDust_json_string(char* buffer);
+void prediction_json_string(char* buffer);
+int weather_senml_cbor(uint8_t* buffer);
+int battery_senml_cbor(uint8_t* buffer);
+int gen_power_senml_cbor(uint8_t* buffer);
+int relay_senml_cbor(uint8_t* buffer);
+int antiDust_senml_cbor(uint8_t* buffer);
+
+static volatile float sink;
+
+// snprintf based str() the nodes used before fixed-fmt.c, for comparison
+static char* snprintf_float(float value, char* output)
+{
+    int integer = (int) value;
+    float fraction = value - integer;
+    fraction = fraction < 0 ? -fraction : fraction; // abs
+    int fraction_int = (int)(fraction * 1000);
+    const char* zeros = fraction_int == 0.0 ? "" : 
+                    fraction_int < 10 ? "00" : 
+                    fraction_int < 100 ? "0" : "";
+    int snlen = snprintf(output, 16, "%d.%s%d", integer, zeros, fraction_int);
+    output[snlen] = '\0'; // Ensure null termination
+    return output;
+}
+
+PROCESS(energy_node_bench_process, "Energy Node Benchmark");
+
+PROCESS_THREAD(energy_node_bench_process, ev, data)
+{
+    static char buffer[COAP_MAX_CHUNK_SIZE];
+    const unsigned long n = NODE_BENCH_ITERATIONS;
+
+    PROCESS_BEGIN();
+
+    node_bench_header("energy-node");
+
+    NODE_BENCH("solar_power_evaluate", n, sink = solar_power_evaluate(), 0);
+    NODE_BENCH("solar_power_predict", n, sink = solar_power_predict(), 0);
+
+    // forecast: 16 steps of the weather trend, then the model on batches
+    // of K of them, per sample
+    static float inputs[16 * 3], forecast[16];
+    NODE_BENCH("weather_extrapolate_16", n, weather_extrapolate(inputs, 16, CLOCK_SECOND * 60), 0);
+    NODE_BENCH_BATCH("evaluate_batch_k1", n, 1, solar_power_evaluate_batch(inputs, 1, forecast));
+    NODE_BENCH_BATCH("evaluate_batch_k4", n, 4, solar_power_evaluate_batch(inputs, 4, forecast));
+    NODE_BENCH_BATCH("evaluate_batch_k16", n, 16, solar_power_evaluate_batch(inputs, 16, forecast));
+    NODE_BENCH("update_gen_power", n, update_gen_power(), 0);
+
+    NODE_BENCH("snprintf_float", n, snprintf_float(1523.871f, buffer), strlen(buffer));
+    NODE_BENCH("fmt_float", n, fmt_float(1523.871f, buffer), strlen(buffer));
+
+    NODE_BENCH("weather_json_string", n, weather_json_string(buffer), strlen(buffer));
+    NODE_BENCH("battery_json_string", n, battery_json_string(buffer), strlen(buffer));
+    NODE_BENCH("gen_power_json_string", n, gen_power_json_string(buffer), strlen(buffer));
+    NODE_BENCH("relay_json_string", n, relay_json_string(buffer), strlen(buffer));
+    NODE_BENCH("antiDust_json_string", n, antiDust_json_string(buffer), strlen(buffer));
+    NODE_BENCH("prediction_json_string", n, prediction_json_string(buffer), strlen(buffer));
+
+    static int len;
+    NODE_BENCH("weather_senml_cbor", n, len = weather_senml_cbor((uint8_t *)buffer), len);
+    NODE_BENCH("battery_senml_cbor", n, len = battery_senml_cbor((uint8_t *)buffer), len);
+    NODE_BENCH("gen_power_senml_cbor", n, len = gen_power_senml_cbor((uint8_t *)buffer), len);
+    NODE_BENCH("relay_senml_cbor", n, len = relay_senml_cbor((uint8_t *)buffer), len);
+    NODE_BENCH("antiDust_senml_cbor", n, len = antiDust_senml_cbor((uint8_t *)buffer), len);
+
+    exit(0);
+
+    PROCESS_END();
+}
@@ -8,6 +8,14 @@
 #include "os/dev/button-hal.h"
 #include "os/dev/leds.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "profile.h"
+#include "task-sched.h"
+#include "node-config.h"
+#include "checkpoint.h"
+#include "checkpoint-ids.h"
+#include "residual-detector.h"
+#include "linear-calibration.h"
 
 /* Log configuration */
 #define LOG_MODULE "ENERGY"
@@ -22,20 +30,46 @@
 
 #define SETTINGS_URI "/settings"
 
-// Publish intervals
+// Publish intervals, defaults of the config resource (sensors: first
+// sample only, then adaptive)
 #define LONG_INTERVAL CLOCK_SECOND * 15
 #define SHORT_INTERVAL CLOCK_SECOND * 7
 #define ANTIDUST_INTERVAL CLOCK_SECOND * 5
 #define BLINK_INTERVAL CLOCK_SECOND * 0.1
 
+// Night: no irradiance, the intervals are stretched
+#define NIGHT_IRRADIATION 0.01
+#define SENSORS_NIGHT_STRETCH 1 // the weather sampler lengthens it
+#define GEN_POWER_NIGHT_STRETCH 4
+#define PREDICTION_NIGHT_STRETCH 8
+
 // Power parameters
 #define MAX_POWER 3000.0 // in W
-#define MAX_OFFSET_PREDICTION 0.1 * MAX_POWER
-#define WRONG_PREDICTIONS_THRESHOLD_DUST 2
-#define WRONG_PREDICTIONS_THRESHOLD_ALARM 4
+
+// Anomaly detection on the prediction residual, defaults of the config
+// resource. The residual is the power shortfall per unit of irradiance
+// (fraction of MAX_POWER): a dusty panel loses a share of its power
+// whatever the sun.
+#define ANOMALY_MIN_IRRADIATION 0.25 // below, the noise dominates the residual
+#define ANOMALY_DRIFT 0.05 // shortfall that does not accumulate
+#define ANOMALY_LIMIT 0.2 // larger shortfalls count as this one
+#define ANOMALY_DUST 0.2 // accumulated shortfall: anti-dust cycle
+#define ANOMALY_ALARM 0.4 // accumulated shortfall: alarm
+
+// Recalibration of the model output to the panel: gain and offset fitted
+// on the CALIBRATION_WINDOW prediction cycles with sun that follow a
+// cleaning (end of an anti-dust cycle or of an alarm), when the panel
+// should be clean. Samples whose residual is beyond the anomaly limit are
+// outliers (passing shade, sensor glitch) and are left out of the fit,
+// but still use up the window.
+#define CALIBRATION_WINDOW 8 // prediction cycles, default of the config resource
+#define CALIBRATION_GAIN_MIN 0.7
+#define CALIBRATION_GAIN_MAX 1.3
+#define CALIBRATION_OFFSET_MAX (0.05 * MAX_POWER)
+#define CALIBRATION_MIN_SPREAD (0.02 * MAX_POWER) // W, to fit the gain
 
 // Resources
-extern coap_resource_t res_weather, res_battery, res_gen_power, res_relay, res_antiDust;
+extern coap_resource_t res_weather, res_battery, res_gen_power, res_all, res_relay, res_antiDust, res_diag, res_history, res_tasks, res_config, res_forecast, res_model;
 
 //extern variables and functions
 enum antiDust_t {ANTIDUST_OFF, ANTIDUST_ON, ANTIDUST_ALARM};
@@ -48,16 +82,53 @@ void update_antiDust(enum antiDust_t newState);
 void updateChargeRate(float rate);
 void updateBatteryChargeRate();
 void update_relay(enum relay_sp_t new_relay_sp, enum relay_home_t new_relay_home, float new_power_sp, float new_power_home);
-extern float charge_rate;
 extern enum relay_sp_t relay_sp;
 extern float power_sp;
 extern enum antiDust_t antiDustState;
+float weather_irradiation();
+clock_time_t weather_sample_interval();
+void model_restore();
 
 // Status
 enum status_t {STATUS_ON, STATUS_ANTIDUST, STATUS_ALARM};
 enum status_t energyNodeStatus = STATUS_ON;
 
-static unsigned int nWrongPredictions = 0; // Counter for wrong predictions
+// Residual of the predictions, see diag/anomaly and res-config.c
+residual_detector_t prediction_detector = { ANOMALY_DRIFT, ANOMALY_LIMIT, ANOMALY_DUST, ANOMALY_ALARM };
+static unsigned long anomaly_dust_cycles = 0;
+static unsigned long anomaly_alarms = 0;
+
+// Correction of the model output, see diag/calibration and res-config.c
+linear_calibration_t prediction_calibration = {
+    CALIBRATION_GAIN_MIN, CALIBRATION_GAIN_MAX, CALIBRATION_OFFSET_MAX, CALIBRATION_MIN_SPREAD, { 1.0 }
+};
+int32_t calibration_window = CALIBRATION_WINDOW;
+static int32_t calibration_left = 0; // prediction cycles left in the window
+static float last_raw_prediction = 0.0;
+static float last_prediction = 0.0; // calibrated
+
+// State kept across reboots, see checkpoint.h
+extern checkpoint_item_t battery_checkpoint, relay_checkpoint, model_checkpoint;
+// The CUSUM moves with every daylight sample: at most once a minute. The
+// EWMA statistics are diagnostics only and start again from 0.
+static checkpoint_item_t predictions_checkpoint = { CKPT_PREDICTIONS, 3, CLOCK_SECOND * 60, {
+    { &prediction_detector.cusum, sizeof(prediction_detector.cusum) },
+    { &prediction_detector.level, sizeof(prediction_detector.level) },
+} };
+// the correction and the averages it comes from, so that the next window
+// goes on with the same fit
+static checkpoint_item_t calibration_checkpoint = { CKPT_CALIBRATION, 2, 0, {
+    { &prediction_calibration.fit, sizeof(prediction_calibration.fit) },
+} };
+static checkpoint_item_t *const checkpoints[] = {
+    &battery_checkpoint, &relay_checkpoint, &predictions_checkpoint, &model_checkpoint,
+    &calibration_checkpoint, NULL
+};
+
+// Control parameters, see res-config.c
+clock_time_t short_interval = SHORT_INTERVAL;
+clock_time_t antidust_interval = ANTIDUST_INTERVAL;
+extern const config_t node_config;
 
 static struct etimer blink_timer;
 static struct etimer alarm_timer;
@@ -67,23 +138,28 @@ static struct etimer sleep_timer;
 // CoAP observation
 coap_endpoint_t hvac_node_endpoint;
 
-char* str(float value, char* output)
-{
-    int integer = (int) value;
-    float fraction = value - integer;
-    fraction = fraction < 0 ? -fraction : fraction; // abs
-    int fraction_int = (int)(fraction * 1000);
-    const char* zeros = fraction_int == 0.0 ? "" : 
-                    fraction_int < 10 ? "00" : 
-                    fraction_int < 100 ? "0" : "";
-    int snlen = snprintf(output, 16, "%d.%s%d", integer, zeros, fraction_int);
-    output[snlen] = '\0'; // Ensure null termination
-    return output;
-}
+// CPU time of the control cycle branches, see diag/energest
+profile_t profile_sensors = { "sensors" };
+profile_t profile_gen_power = { "gen_power" };
+profile_t profile_prediction = { "prediction" };
+
+static void run_sensors(void);
+static void run_gen_power(void);
+static void run_prediction(void);
+
+// Control cycle, aligned on common wakeups by the scheduler
+static task_t sensors_task = { "sensors", run_sensors, LONG_INTERVAL, SENSORS_NIGHT_STRETCH };
+static task_t gen_power_task = { "gen_power", run_gen_power, SHORT_INTERVAL, GEN_POWER_NIGHT_STRETCH };
+static task_t prediction_task = { "prediction", run_prediction, SHORT_INTERVAL, PREDICTION_NIGHT_STRETCH };
 
 // Process
 PROCESS(energy_node_process, "Energy Node Process");
+#if NODE_BENCH
+PROCESS_NAME(energy_node_bench_process);
+AUTOSTART_PROCESSES(&energy_node_bench_process);
+#else
 AUTOSTART_PROCESSES(&energy_node_process);
+#endif
 
 static void alarm_handler()
 {
@@ -106,6 +182,10 @@ static void alarm_handler()
 static void restart()
 {
     energyNodeStatus = STATUS_ON;
+    // panel checked: the shortfall accumulates again from 0
+    residual_detector_reset(&prediction_detector);
+    checkpoint_save(&predictions_checkpoint);
+    calibration_left = calibration_window;
     update_antiDust(ANTIDUST_OFF); // Disable anti-dust mode
 
 #if PLATFORM_HAS_LEDS || LEDS_COUNT
@@ -134,8 +214,8 @@ static void antidust_handler()
 #if PLATFORM_HAS_LEDS || LEDS_COUNT
     etimer_set(&blink_timer, BLINK_INTERVAL);
 #endif
-    etimer_set(&end_antiDust_timer, ANTIDUST_INTERVAL);
-    LOG_WARN("Anti-dust mode active, will end in %d seconds\n", (int) (ANTIDUST_INTERVAL / CLOCK_SECOND));
+    etimer_set(&end_antiDust_timer, antidust_interval);
+    LOG_WARN("Anti-dust mode active, will end in %d seconds\n", (int) (antidust_interval / CLOCK_SECOND));
 
     res_gen_power.trigger();
 
@@ -149,6 +229,7 @@ static void antidust_handler()
 static void end_antidust_handler()
 {
     energyNodeStatus = STATUS_ON;
+    calibration_left = calibration_window; // clean panel
     update_antiDust(ANTIDUST_OFF); // Disable anti-dust mode
 
 #if PLATFORM_HAS_LEDS || LEDS_COUNT
@@ -168,29 +249,91 @@ static void end_antidust_handler()
     res_antiDust.trigger();
 }
 
-static void analyze_prediction(float prediction)
+static void analyze_prediction(float raw_prediction)
 {
-    if (gen_power >= prediction - MAX_OFFSET_PREDICTION)
-    {
-        nWrongPredictions = 0;
-        return; // No change in status
+    float irradiation = weather_irradiation();
+    if (irradiation < ANOMALY_MIN_IRRADIATION)
+        return; // no sun, nothing to compare
+
+    float prediction = linear_calibration_apply(&prediction_calibration, raw_prediction);
+    float residual = (prediction - gen_power) / (MAX_POWER * irradiation);
+    last_raw_prediction = raw_prediction;
+    last_prediction = prediction;
+
+    // clean panel: the correction learns the panel, bias included, but not
+    // from outliers. The window closes after calibration_window cycles
+    // whether or not their samples were kept.
+    if (calibration_left > 0) {
+        if (residual <= prediction_detector.limit && residual >= -prediction_detector.limit) {
+            linear_calibration_update(&prediction_calibration, raw_prediction, gen_power);
+            checkpoint_save(&calibration_checkpoint);
+        }
+        calibration_left--;
     }
 
-    char gen_power_str[16], prediction_str[16];
-    LOG_WARN("Generated power is low: %sW, prediction: %sW\n", str(gen_power, gen_power_str), str(prediction, prediction_str));
-    nWrongPredictions++;
+    enum residual_level_t level = residual_detector_update(&prediction_detector, residual);
+    checkpoint_save(&predictions_checkpoint);
+
+    if (residual > prediction_detector.drift) {
+        char gen_power_str[FMT_FLOAT_BUF_SIZE], prediction_str[FMT_FLOAT_BUF_SIZE];
+        LOG_WARN("Generated power is low: %sW, prediction: %sW\n", fmt_float(gen_power, gen_power_str), fmt_float(prediction, prediction_str));
+    }
 
-    if (nWrongPredictions == WRONG_PREDICTIONS_THRESHOLD_ALARM)
+    if (level == RESIDUAL_ALARM)
     {
-        LOG_ERR("Too many wrong predictions, triggering alarm!\n");
+        LOG_ERR("Lasting power shortfall, triggering alarm!\n");
+        anomaly_alarms++;
         alarm_handler();
     } 
-    else if (nWrongPredictions == WRONG_PREDICTIONS_THRESHOLD_DUST)
+    else if (level == RESIDUAL_WARNING)
     {
-        LOG_WARN("Too many wrong predictions, switching to anti-dust mode!\n");
+        LOG_WARN("Power shortfall building up, switching to anti-dust mode!\n");
+        anomaly_dust_cycles++;
         antidust_handler();
     }
 }
+
+// New model, see res-model.c: the residuals of the old one do not add up
+// with the new ones, and the correction was fitted on its raw output
+void prediction_model_changed()
+{
+    residual_detector_reset(&prediction_detector);
+    checkpoint_save(&predictions_checkpoint);
+    linear_calibration_reset(&prediction_calibration);
+    checkpoint_save(&calibration_checkpoint);
+}
+
+void calibration_json_string(char *buffer)
+{
+    char *p = fmt_str(buffer, "{\"n\":\"calibration\",\"raw\":");
+    p = fmt_fixed(p, last_raw_prediction, 1);
+    p = fmt_str(p, ",\"cal\":");
+    p = fmt_fixed(p, last_prediction, 1);
+    p = fmt_str(p, ",");
+    p = linear_calibration_json(p, &prediction_calibration);
+    p = fmt_str(p, ",\"left\":");
+    p = fmt_int(p, calibration_left);
+    fmt_str(p, "}");
+}
+
+void anomaly_json_string(char *buffer)
+{
+    char *p = fmt_str(buffer, "{\"n\":\"anomaly\",");
+    p = residual_detector_json(p, &prediction_detector);
+    p = fmt_str(p, ",\"drift\":");
+    p = fmt_fixed(p, prediction_detector.drift, 4);
+    p = fmt_str(p, ",\"limit\":");
+    p = fmt_fixed(p, prediction_detector.limit, 4);
+    p = fmt_str(p, ",\"dust\":");
+    p = fmt_fixed(p, prediction_detector.warning, 4);
+    p = fmt_str(p, ",\"alarm\":");
+    p = fmt_fixed(p, prediction_detector.alarm, 4);
+    p = fmt_str(p, ",\"dust_cycles\":");
+    p = fmt_int(p, anomaly_dust_cycles);
+    p = fmt_str(p, ",\"alarms\":");
+    p = fmt_int(p, anomaly_alarms);
+    fmt_str(p, "}");
+}
 static process_event_t blink_process;
 void set_antidust_handler(enum antiDust_t oldState)
 {
@@ -211,14 +354,76 @@ void set_antidust_handler(enum antiDust_t oldState)
         LOG_ERR("Invalid antiDust state transition: %d -> %d\n", oldState, antiDustState);
 }
 
+static void run_sensors(void)
+{
+    rtimer_clock_t start = profile_start();
+
+    // Trigger weather and battery resources, their notification
+    // policies decide whether observers are notified
+    res_weather.trigger();
+    res_battery.trigger();
+
+    // adaptive: shorter while the weather is changing
+    task_sched_set_interval(&sensors_task, weather_sample_interval(), sensors_task.night_stretch);
+
+    bool night = weather_irradiation() <= NIGHT_IRRADIATION;
+    if (night != task_sched_is_night()) {
+        LOG_INFO(night ? "Night, stretched intervals\n" : "Day, normal intervals\n");
+        task_sched_set_night(night);
+    }
+    profile_stop(&profile_sensors, start);
+}
+
+static void run_gen_power(void)
+{
+    rtimer_clock_t start = profile_start();
+
+    // Trigger power generation resource
+    if (energyNodeStatus == STATUS_ON) {
+        res_gen_power.trigger();
+        updateBatteryChargeRate();
+        if (relay_sp == RELAY_SP_BATTERY || relay_sp == RELAY_SP_GRID)
+            power_sp = gen_power;
+    }
+    profile_stop(&profile_gen_power, start);
+}
+
+static void run_prediction(void)
+{
+    rtimer_clock_t start = profile_start();
+
+    if (energyNodeStatus == STATUS_ON)
+    {
+        // Trigger prediction logic
+        float prediction = solar_power_predict();
+        char pred[FMT_FLOAT_BUF_SIZE];
+        LOG_DBG("Solar power prediction: %sW\n", fmt_float(prediction, pred));
+        analyze_prediction(prediction);
+    }
+    // Trigger the forecast, its notification policy decides whether
+    // observers are notified
+    res_forecast.trigger();
+    profile_stop(&profile_prediction, start);
+}
+
+// Longest gap between two gen_power triggers, for the Max-Age of its
+// notifications: 0 out of STATUS_ON, the next one comes with the status
+clock_time_t gen_power_trigger_interval()
+{
+    return energyNodeStatus == STATUS_ON ? task_sched_longest_interval(&gen_power_task) : 0;
+}
+
+// New control parameters, from the config resource
+void apply_config()
+{
+    task_sched_set_interval(&gen_power_task, short_interval, gen_power_task.night_stretch);
+    task_sched_set_interval(&prediction_task, short_interval, prediction_task.night_stretch);
+}
+
 static coap_callback_request_state_t req_state;
 
 PROCESS_THREAD(energy_node_process, ev, data) 
 {
-    static struct etimer weather_battery_timer;
-    static struct etimer gen_power_timer;
-    static struct etimer prediction_timer;
-
     static bool long_press = false;
 
     PROCESS_BEGIN();
@@ -233,13 +438,26 @@ PROCESS_THREAD(energy_node_process, ev, data)
 
     blink_process = process_alloc_event();
 
+    // Saved control parameters and state (warm restart)
+    config_load(&node_config);
+    if (checkpoint_restore(checkpoints) > 0)
+        updateBatteryChargeRate(); // restored relays
+    model_restore();
+
     LOG_INFO("Starting energy node\n");
     // Initialize resources
     coap_activate_resource(&res_weather, "sensors/weather");
     coap_activate_resource(&res_battery, "sensors/battery");
     coap_activate_resource(&res_gen_power, "sensors/power");
+    coap_activate_resource(&res_all, "sensors/all");
     coap_activate_resource(&res_relay, "relay");
     coap_activate_resource(&res_antiDust, "antiDust");
+    coap_activate_resource(&res_diag, "diag");
+    coap_activate_resource(&res_history, "history");
+    coap_activate_resource(&res_tasks, "tasks");
+    coap_activate_resource(&res_config, "config");
+    coap_activate_resource(&res_forecast, "forecast");
+    coap_activate_resource(&res_model, "model");
 
     // Initialize CoAP endpoint
     coap_endpoint_parse(HVAC_NODE_EP, strlen(HVAC_NODE_EP), &hvac_node_endpoint);
@@ -267,43 +485,20 @@ PROCESS_THREAD(energy_node_process, ev, data)
     #endif
 #endif
 
-    // Initialize timers
-    etimer_set(&weather_battery_timer, LONG_INTERVAL);
-    etimer_set(&gen_power_timer, SHORT_INTERVAL);
-    etimer_set(&prediction_timer, SHORT_INTERVAL);
+    // Initialize the periodic tasks, prediction after gen_power
+    task_sched_init(&energy_node_process);
+    task_sched_add(&sensors_task);
+    task_sched_add(&gen_power_task);
+    task_sched_add(&prediction_task);
 
     while(1) {
         PROCESS_WAIT_EVENT();
 
         if (ev == PROCESS_EVENT_TIMER)
         {
-            if (data == &weather_battery_timer) {
-                // Trigger weather and battery resources
-                res_weather.trigger();
-                if (charge_rate != 0.0)
-                    res_battery.trigger(); // Trigger battery only if charge rate is set
-                etimer_reset(&weather_battery_timer);
-            }
-            else if (data == &gen_power_timer) {
-                // Trigger power generation resource
-                if (energyNodeStatus == STATUS_ON) {
-                    res_gen_power.trigger();
-                    updateBatteryChargeRate();
-                    if (relay_sp == RELAY_SP_BATTERY || relay_sp == RELAY_SP_GRID)
-                        power_sp = gen_power;
-                }
-                etimer_reset(&gen_power_timer);
-            }
-            else if (data == &prediction_timer) {
-                if (energyNodeStatus == STATUS_ON)
-                {
-                    // Trigger prediction logic
-                    float prediction = solar_power_predict();
-                    char pred[16];
-                    LOG_DBG("Solar power prediction: %sW\n", str(prediction, pred));
-                    analyze_prediction(prediction);
-                }
-                etimer_reset(&prediction_timer);
+            if (task_sched_expired(data)) {
+                // Tasks due on this wakeup
+                task_sched_run();
             }
             else if (data == &end_antiDust_timer) {
                 if (energyNodeStatus == STATUS_ANTIDUST) {
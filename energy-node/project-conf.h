@@ -53,6 +53,18 @@
 #undef UIP_CONF_BUFFER_SIZE
 #define UIP_CONF_BUFFER_SIZE    240
 
+// CPU, low power mode and radio times for diag/energest
+#define ENERGEST_CONF_ON 1
+
+#if NODE_BENCH
+#define LOG_LEVEL_APP LOG_LEVEL_WARN
+#else
 #define LOG_LEVEL_APP LOG_LEVEL_INFO
+#endif
+
+// Use the int8 quantized solar power model (solar-power-model-q8.h)
+#define SOLAR_POWER_MODEL_CONF_Q8 1
+// Without Q8: use the pruned float model (solar-power-model-sparse.h)
+#define SOLAR_POWER_MODEL_CONF_SPARSE 1
 
 #endif /* PROJECT_CONF_H_ */
@@ -0,0 +1,343 @@
+#ifndef Q8_NET_H_
+#define Q8_NET_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#include "cmsis_compiler.h" // __SMLAD, __PKHBT
+#elif defined(__SSE2__)
+#include <emmintrin.h> // _mm_madd_epi16
+#endif
+
+// Integer-only MLP inference for the quantized solar power model.
+// Weights are int8 with one scale per layer, activations int16 and
+// accumulators int32: the inner loops run without soft-float.
+// Models are generated by ML-expected-solar-power/quantize_model.py
+//
+// q8_net_regress() evaluates a batch of samples one layer at a time: each
+// pair of weights of a row is loaded once for all the samples. The
+// activations of a batch are stored by pairs of neurons,
+// [neuron / 2][sample][neuron % 2], so that the two inputs of a sample
+// that meet a pair of weights are adjacent: one SMLAD (two MACs) per pair
+// on Cortex-M4, one pmaddwd per pair and 4 samples with SSE2 (native).
+
+#ifdef Q8_NET_CONF_BATCH
+#define Q8_NET_BATCH Q8_NET_CONF_BATCH
+#else
+#define Q8_NET_BATCH 16 // samples per layer pass, the buffers hold as many
+#endif
+
+// Activation of neuron for sample, in a batch of n_samples
+#define Q8_NET_AT(neuron, sample, n_samples) \
+    (((neuron) >> 1) * 2 * (n_samples) + (sample) * 2 + ((neuron) & 1))
+
+typedef enum _Q8NetActivationFunction {
+    Q8NetActivationIdentity = 0,
+    Q8NetActivationRelu,
+} Q8NetActivationFunction;
+
+typedef struct _Q8NetLayer {
+    int32_t n_outputs;
+    int32_t n_inputs;
+    const int8_t *weights;  // [n_outputs][n_inputs], one row per neuron
+    const int32_t *biases;  // already in accumulator scale
+    int32_t multiplier;     // requantization to the next layer input scale:
+    int32_t shift;          // out = (acc * multiplier) >> shift
+    Q8NetActivationFunction activation;
+} Q8NetLayer;
+
+typedef struct _Q8Net {
+    int32_t n_layers;
+    const Q8NetLayer *layers;
+    int16_t *activations1;
+    int16_t *activations2;
+    int32_t activations_length;
+    const float *input_scales;  // inverse scale of each input feature
+    float output_scale;         // last layer accumulator to float
+} Q8Net;
+
+static inline int16_t
+q8_net_saturate(int64_t value)
+{
+    if (value > INT16_MAX)
+        return INT16_MAX;
+    if (value < -INT16_MAX)
+        return -INT16_MAX;
+    return (int16_t) value;
+}
+
+static inline int32_t
+q8_net_dot(const int8_t *row, const int16_t *in, int32_t n_inputs, int32_t acc)
+{
+    for (int32_t i = 0; i < n_inputs; i++)
+        acc += (int32_t) row[i] * (int32_t) in[i];
+    return acc;
+}
+
+static void
+q8_net_layer_forward(const Q8NetLayer *layer, const int16_t *in, int16_t *out)
+{
+    const int64_t round = (int64_t) 1 << (layer->shift - 1);
+    const int8_t *row = layer->weights;
+
+    for (int32_t o = 0; o < layer->n_outputs; o++) {
+        int32_t acc = q8_net_dot(row, in, layer->n_inputs, layer->biases[o]);
+        row += layer->n_inputs;
+
+        if (layer->activation == Q8NetActivationRelu && acc < 0)
+            acc = 0;
+        out[o] = q8_net_saturate(((int64_t) acc * layer->multiplier + round) >> layer->shift);
+    }
+}
+
+// Quantized inputs, the only float operations before the output
+static inline void
+q8_net_quantize(const Q8Net *net, const float *features, int32_t n_features, int16_t *in)
+{
+    for (int32_t i = 0; i < n_features; i++) {
+        float q = features[i] * net->input_scales[i];
+        if (q > INT16_MAX)
+            q = INT16_MAX;
+        else if (q < -INT16_MAX)
+            q = -INT16_MAX;
+        in[i] = (int16_t)(q >= 0.0f ? q + 0.5f : q - 0.5f);
+    }
+}
+
+// Single output regression, NAN on size mismatch
+static float
+q8_net_regress1(const Q8Net *net, const float *features, int32_t n_features)
+{
+    const Q8NetLayer *first = &net->layers[0];
+    const Q8NetLayer *last = &net->layers[net->n_layers - 1];
+
+    if (n_features != first->n_inputs || last->n_outputs != 1)
+        return NAN;
+
+    int16_t *in = net->activations1;
+    int16_t *out = net->activations2;
+    q8_net_quantize(net, features, n_features, in);
+
+    for (int32_t l = 0; l < net->n_layers - 1; l++) {
+        q8_net_layer_forward(&net->layers[l], in, out);
+        int16_t *tmp = in;
+        in = out;
+        out = tmp;
+    }
+
+    int32_t acc = q8_net_dot(last->weights, in, last->n_inputs, last->biases[0]);
+    if (last->activation == Q8NetActivationRelu && acc < 0)
+        acc = 0;
+    return (float) acc * net->output_scale;
+}
+
+// Accumulators of a weight row with the inputs of n samples. With an
+// odd number of inputs the last pair has a weight of 0, whatever is in
+// the unused slot.
+static inline void
+q8_net_dot_batch(const int8_t *row, const int16_t *restrict in, int32_t n_inputs, int32_t n_samples, int32_t *restrict acc)
+{
+    for (int32_t i = 0; i < n_inputs; i += 2) {
+        const int32_t w0 = row[i];
+        const int32_t w1 = i + 1 < n_inputs ? row[i + 1] : 0;
+        const int16_t *x = in + i * n_samples;
+        int32_t s = 0;
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+        const uint32_t w = __PKHBT(w0, w1, 16);
+        for (; s < n_samples; s++) {
+            uint32_t x01;
+            memcpy(&x01, x + 2 * s, sizeof(x01));
+            acc[s] = __SMLAD(w, x01, acc[s]);
+        }
+#elif defined(__SSE2__)
+        const __m128i w = _mm_set1_epi32((int32_t) (uint16_t) w0 | (int32_t) ((uint32_t) w1 << 16));
+        for (; s + 4 <= n_samples; s += 4) {
+            __m128i x4 = _mm_loadu_si128((const __m128i *) (x + 2 * s));
+            __m128i a4 = _mm_loadu_si128((const __m128i *) (acc + s));
+            _mm_storeu_si128((__m128i *) (acc + s), _mm_add_epi32(a4, _mm_madd_epi16(w, x4)));
+        }
+#endif
+        for (; s < n_samples; s++)
+            acc[s] += w0 * x[2 * s] + w1 * x[2 * s + 1];
+    }
+}
+
+static void
+q8_net_layer_forward_batch(const Q8NetLayer *layer, const int16_t *in, int16_t *out, int32_t n_samples)
+{
+    const int64_t round = (int64_t) 1 << (layer->shift - 1);
+    const int8_t *row = layer->weights;
+    int32_t acc[Q8_NET_BATCH];
+
+    for (int32_t o = 0; o < layer->n_outputs; o++) {
+        for (int32_t s = 0; s < n_samples; s++)
+            acc[s] = layer->biases[o];
+        q8_net_dot_batch(row, in, layer->n_inputs, n_samples, acc);
+        row += layer->n_inputs;
+
+        for (int32_t s = 0; s < n_samples; s++) {
+            if (layer->activation == Q8NetActivationRelu && acc[s] < 0)
+                acc[s] = 0;
+            out[Q8_NET_AT(o, s, n_samples)] = q8_net_saturate(((int64_t) acc[s] * layer->multiplier + round) >> layer->shift);
+        }
+    }
+}
+
+// Single output regression of n_samples samples of n_features features,
+// Q8_NET_BATCH at a time. buf1 and buf2 hold Q8_NET_BATCH activations of
+// the widest layer, rounded up to an even number. Returns 0, or -1 on
+// size mismatch.
+static int32_t
+q8_net_regress(const Q8Net *net, const float *features, int32_t n_features, int32_t n_samples,
+               int16_t *buf1, int16_t *buf2, float *outputs)
+{
+    const Q8NetLayer *first = &net->layers[0];
+    const Q8NetLayer *last = &net->layers[net->n_layers - 1];
+
+    if (n_features != first->n_inputs || last->n_outputs != 1)
+        return -1;
+
+    for (int32_t start = 0; start < n_samples; start += Q8_NET_BATCH) {
+        int32_t n = n_samples - start < Q8_NET_BATCH ? n_samples - start : Q8_NET_BATCH;
+        if (n == 1) {
+            // nothing to share between samples
+            outputs[start] = q8_net_regress1(net, features + start * n_features, n_features);
+            continue;
+        }
+        int16_t *in = buf1;
+        int16_t *out = buf2;
+        int32_t acc[Q8_NET_BATCH];
+
+        // quantized in out, free until the first layer, then interleaved
+        for (int32_t s = 0; s < n; s++) {
+            q8_net_quantize(net, features + (start + s) * n_features, n_features, out + s * n_features);
+            for (int32_t i = 0; i < n_features; i++)
+                in[Q8_NET_AT(i, s, n)] = out[s * n_features + i];
+        }
+
+        for (int32_t l = 0; l < net->n_layers - 1; l++) {
+            q8_net_layer_forward_batch(&net->layers[l], in, out, n);
+            int16_t *tmp = in;
+            in = out;
+            out = tmp;
+        }
+
+        for (int32_t s = 0; s < n; s++)
+            acc[s] = last->biases[0];
+        q8_net_dot_batch(last->weights, in, last->n_inputs, n, acc);
+        for (int32_t s = 0; s < n; s++) {
+            if (last->activation == Q8NetActivationRelu && acc[s] < 0)
+                acc[s] = 0;
+            outputs[start + s] = (float) acc[s] * net->output_scale;
+        }
+    }
+    return 0;
+}
+
+// Binary model image, loaded at run time instead of a generated header
+// (quantize_model.py --binary). Little-endian, each field aligned on its
+// size:
+//   'Q' '8' 'M' format (u8), revision (u32), size of the image (u32),
+//   n_layers (u8), n_inputs (u8), 0 (u16), output_scale (f32),
+//   input_scales[n_inputs] (f32),
+//   test vector: features[n_inputs] (f32), expected output (f32),
+//   n_layers x { n_outputs (u16), n_inputs (u16), multiplier (i32),
+//                shift (u8), activation (u8), 0 (u16) },
+//   n_layers x { biases[n_outputs] (i32), weights[n_outputs][n_inputs]
+//                (i8), 0 up to a multiple of 4 bytes },
+//   CRC-32 of all the previous bytes (u32, as zlib.crc32)
+#define Q8_NET_IMAGE_FORMAT 1
+#define Q8_NET_IMAGE_HEADER 20
+#define Q8_NET_IMAGE_LAYER 12
+#define Q8_NET_IMAGE_MAX_LAYERS 8
+#define Q8_NET_IMAGE_MAX_INPUTS 8
+
+// A loaded image: the weights and biases stay in the image
+typedef struct _Q8NetImage {
+    Q8Net net; // without activation buffers
+    Q8NetLayer layers[Q8_NET_IMAGE_MAX_LAYERS];
+    float input_scales[Q8_NET_IMAGE_MAX_INPUTS];
+    float test_features[Q8_NET_IMAGE_MAX_INPUTS];
+    float test_output; // expected on test_features
+    uint32_t revision;
+    uint32_t crc;
+} Q8NetImage;
+
+static uint32_t
+q8_net_crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (int32_t k = 0; k < 8; k++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+    }
+    return ~crc;
+}
+
+// Parses the image, 4-byte aligned, into model. Returns 0, or -1 if the
+// image is corrupted or is not a single output network that fits model.
+static int32_t
+q8_net_image_load(Q8NetImage *model, const uint8_t *image, uint32_t size)
+{
+    uint32_t image_size, crc;
+    uint16_t dims[2];
+
+    if (size < Q8_NET_IMAGE_HEADER + sizeof(crc) || memcmp(image, "Q8M", 3) != 0 || image[3] != Q8_NET_IMAGE_FORMAT)
+        return -1;
+    memcpy(&image_size, image + 8, sizeof(image_size));
+    memcpy(&crc, image + size - sizeof(crc), sizeof(crc));
+    if (image_size != size || q8_net_crc32(0, image, size - sizeof(crc)) != crc)
+        return -1;
+
+    int32_t n_layers = image[12];
+    int32_t n_inputs = image[13];
+    uint32_t end = size - sizeof(crc);
+    uint32_t pos = Q8_NET_IMAGE_HEADER + (2 * n_inputs + 1) * sizeof(float);
+    if (n_layers < 1 || n_layers > Q8_NET_IMAGE_MAX_LAYERS || n_inputs < 1 || n_inputs > Q8_NET_IMAGE_MAX_INPUTS
+        || pos + n_layers * Q8_NET_IMAGE_LAYER > end)
+        return -1;
+
+    memcpy(&model->revision, image + 4, sizeof(model->revision));
+    model->crc = crc;
+    memcpy(&model->net.output_scale, image + 16, sizeof(float));
+    memcpy(model->input_scales, image + Q8_NET_IMAGE_HEADER, n_inputs * sizeof(float));
+    memcpy(model->test_features, image + Q8_NET_IMAGE_HEADER + n_inputs * sizeof(float), n_inputs * sizeof(float));
+    memcpy(&model->test_output, image + Q8_NET_IMAGE_HEADER + 2 * n_inputs * sizeof(float), sizeof(float));
+
+    const uint8_t *desc = image + pos;
+    pos += n_layers * Q8_NET_IMAGE_LAYER;
+    for (int32_t l = 0; l < n_layers; l++, desc += Q8_NET_IMAGE_LAYER) {
+        Q8NetLayer *layer = &model->layers[l];
+        memcpy(dims, desc, sizeof(dims));
+        memcpy(&layer->multiplier, desc + 4, sizeof(layer->multiplier));
+        layer->n_outputs = dims[0];
+        layer->n_inputs = dims[1];
+        layer->shift = desc[8];
+        layer->activation = (Q8NetActivationFunction) desc[9];
+
+        uint32_t n_weights = (uint32_t) layer->n_outputs * layer->n_inputs;
+        if (layer->n_outputs < 1 || layer->n_inputs != (l == 0 ? n_inputs : model->layers[l - 1].n_outputs)
+            || desc[9] > Q8NetActivationRelu || (l < n_layers - 1 && (layer->shift < 1 || layer->shift > 62))
+            || n_weights > end || pos + layer->n_outputs * sizeof(int32_t) + n_weights > end)
+            return -1;
+        layer->biases = (const int32_t *) (image + pos);
+        pos += layer->n_outputs * sizeof(int32_t);
+        layer->weights = (const int8_t *) (image + pos);
+        pos += (n_weights + 3) & ~3u;
+    }
+    if (pos != end || model->layers[n_layers - 1].n_outputs != 1)
+        return -1;
+
+    model->net.n_layers = n_layers;
+    model->net.layers = model->layers;
+    model->net.input_scales = model->input_scales;
+    model->net.activations1 = NULL;
+    model->net.activations2 = NULL;
+    model->net.activations_length = 0;
+    return 0;
+}
+
+#endif /* Q8_NET_H_ */
@@ -0,0 +1,10 @@
+#ifndef RES_ALL_H_
+#define RES_ALL_H_
+
+// Fields of the composite /sensors/all resource, see res-all.c. The
+// resources call all_changed() when they notify their own observers.
+enum all_field_t { ALL_WEATHER, ALL_BATTERY, ALL_GEN_POWER, ALL_RELAY, ALL_ANTIDUST, ALL_COUNT };
+
+void all_changed(enum all_field_t field);
+
+#endif /* RES_ALL_H_ */
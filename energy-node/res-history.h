@@ -0,0 +1,11 @@
+#ifndef RES_HISTORY_H_
+#define RES_HISTORY_H_
+
+// Sensors whose samples are kept by the history resource, see
+// res-history.c. The sampling resources call history_add() with each
+// new value.
+enum history_sensor_t { HISTORY_IRR, HISTORY_GEN_POWER, HISTORY_BATTERY, HISTORY_COUNT };
+
+void history_add(enum history_sensor_t sensor, float value);
+
+#endif /* RES_HISTORY_H_ */
@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "coap-chunked.h"
+#include "profile.h"
+#include "sys/ctimer.h"
+#include "../res-all.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "ALL"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// Changes closer than this go out in a single notification
+#ifdef ALL_CONF_BATCH_WINDOW
+#define ALL_BATCH_WINDOW ALL_CONF_BATCH_WINDOW
+#else
+#define ALL_BATCH_WINDOW (CLOCK_SECOND / 2)
+#endif
+
+// external resources
+void weather_json_string(char* buffer);
+void battery_json_string(char* buffer);
+void gen_power_json_string(char* buffer);
+void relay_json_string(char* buffer);
+void antiDust_json_string(char* buffer);
+int weather_senml_cbor(uint8_t* buffer);
+int battery_senml_cbor(uint8_t* buffer);
+int gen_power_senml_cbor(uint8_t* buffer);
+int relay_senml_cbor(uint8_t* buffer);
+int antiDust_senml_cbor(uint8_t* buffer);
+
+// Composite of the energy node resources: each field is the payload of
+// its own resource, so the cloud handles them the same way
+static const struct {
+    const char *name;
+    void (*json_string)(char* buffer);
+    int (*senml_cbor)(uint8_t* buffer);
+} fields[ALL_COUNT] = {
+    [ALL_WEATHER] = { "weather", weather_json_string, weather_senml_cbor },
+    [ALL_BATTERY] = { "battery", battery_json_string, battery_senml_cbor },
+    [ALL_GEN_POWER] = { "gen_power", gen_power_json_string, gen_power_senml_cbor },
+    [ALL_RELAY] = { "relay", relay_json_string, relay_senml_cbor },
+    [ALL_ANTIDUST] = { "antiDust", antiDust_json_string, antiDust_senml_cbor },
+};
+
+#define ALL_FIELDS ((1 << ALL_COUNT) - 1)
+#define FIELD_BUF_SIZE 96 // largest field payload
+
+static uint8_t changed = 0;               // fields changed since their last notification
+static uint8_t notify_selection = ALL_FIELDS; // fields of the last observe registration
+static uint8_t notify_fields = 0;         // fields of the notification being sent
+static uint8_t notify_sent = 0;           // fields that fit in it
+static unsigned int notify_format = APPLICATION_JSON;
+static struct ctimer batch_timer;
+
+// Notification delivery: non-confirmable, unless it carries state changes
+notify_delivery_t all_delivery = { false };
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_event_handler(void);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(all_get, res_get_handler)
+LATENCY_EVENT_HANDLER(all_event, res_event_handler)
+
+EVENT_RESOURCE(res_all,
+                "title=\"All energy node data (?f=weather,battery,gen_power,relay,antiDust)\";rt=\"Sensor[5]\";obs",
+                res_get_handler_timed,
+                NULL,
+                NULL,
+                NULL,
+                res_event_handler_timed);
+
+static void batch_callback(void *ptr)
+{
+    res_all.trigger();
+}
+
+// Starts the batch window if selected fields wait and none is running.
+// Fields outside the selection stay in changed, for the "ch" of a GET,
+// and must not hold the window back.
+static void batch_start(void)
+{
+    if ((changed & notify_selection) != 0 && ctimer_expired(&batch_timer))
+        ctimer_set(&batch_timer, ALL_BATCH_WINDOW, batch_callback, NULL);
+}
+
+// Called by the resources when they notify their own observers
+void all_changed(enum all_field_t field)
+{
+    changed |= 1 << field;
+    batch_start();
+}
+
+// Field mask from f=name,name,...; all the fields without f
+static bool parse_selection(coap_message_t *request, uint8_t *selection)
+{
+    const char *f = NULL;
+    int len = coap_get_query_variable(request, "f", &f);
+
+    *selection = len > 0 ? 0 : ALL_FIELDS;
+    while (len > 0) {
+        int name_len = 0;
+        while (name_len < len && f[name_len] != ',')
+            name_len++;
+
+        int i;
+        for (i = 0; i < ALL_COUNT; i++)
+            if (name_len == (int) strlen(fields[i].name) && strncmp(f, fields[i].name, name_len) == 0)
+                break;
+        if (i == ALL_COUNT)
+            return false;
+        *selection |= 1 << i;
+
+        f += name_len + 1;
+        len -= name_len + 1;
+    }
+    return *selection != 0;
+}
+
+typedef struct {
+    uint8_t fields;   // fields to send
+    uint8_t changed;  // "ch" bitmap
+    int32_t limit;    // notifications: fields that do not fit are left out
+    uint8_t included; // fields sent
+} all_query_t;
+
+// {"n":"all","ch":<bitmap>,"d":[<field payload>,...]}
+static void all_json_generator(coap_chunked_t *out, void *data)
+{
+    all_query_t *query = data;
+    char field[FIELD_BUF_SIZE];
+    int32_t size = strlen("{\"n\":\"all\",\"ch\":31,\"d\":[]}");
+
+    query->included = 0;
+    for (int i = 0; i < ALL_COUNT; i++) {
+        if (!(query->fields & (1 << i)))
+            continue;
+        fields[i].json_string(field);
+        int len = strlen(field) + (query->included != 0); // comma
+        if (query->limit > 0 && size + len > query->limit)
+            continue;
+        size += len;
+        query->included |= 1 << i;
+    }
+    if (query->limit > 0)
+        query->changed = query->included;
+
+    char *p = fmt_str(field, "{\"n\":\"all\",\"ch\":");
+    p = fmt_int(p, query->changed);
+    fmt_str(p, ",\"d\":[");
+    coap_chunked_put(out, field);
+
+    bool first = true;
+    for (int i = 0; i < ALL_COUNT; i++) {
+        if (query->included & (1 << i)) {
+            if (!first)
+                coap_chunked_put(out, ",");
+            fields[i].json_string(field);
+            coap_chunked_put(out, field);
+            first = false;
+        }
+    }
+    coap_chunked_put(out, "]}");
+}
+
+// SenML pack of {bn:"all/",n:"ch"} and the records of the fields
+static void all_senml_cbor_generator(coap_chunked_t *out, void *data)
+{
+    all_query_t *query = data;
+    uint8_t field[FIELD_BUF_SIZE];
+    uint8_t n_records = 1;
+    int32_t size = senml_cbor_record(field, "all/", "ch", 0xff) - field; // largest ch
+
+    // the pack header needs the number of records first
+    query->included = 0;
+    for (int i = 0; i < ALL_COUNT; i++) {
+        if (!(query->fields & (1 << i)))
+            continue;
+        int len = fields[i].senml_cbor(field) - 1; // records without their pack header
+        if (query->limit > 0 && 1 + size + len > query->limit)
+            continue;
+        size += len;
+        n_records += field[0] & 0x1f;
+        query->included |= 1 << i;
+    }
+    if (query->limit > 0)
+        query->changed = query->included;
+
+    uint8_t *p = senml_cbor_pack(field, n_records);
+    p = senml_cbor_record(p, "all/", "ch", query->changed);
+    coap_chunked_write(out, field, p - field);
+    for (int i = 0; i < ALL_COUNT; i++) {
+        if (query->included & (1 << i)) {
+            int len = fields[i].senml_cbor(field);
+            coap_chunked_write(out, field + 1, len - 1);
+        }
+    }
+}
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    if (offset == NULL)
+        notify_delivery_prepare(&all_delivery, response);
+
+    all_query_t query = { 0, 0, 0, 0 };
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+
+    if (format != APPLICATION_JSON && format != SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+        return;
+    }
+
+    if (offset == NULL) {
+        // notification: the changed fields that fit in one message
+        query.fields = notify_fields;
+        query.changed = notify_fields;
+        query.limit = preferred_size;
+    } else {
+        uint32_t observe;
+        if (!parse_selection(request, &query.fields)) {
+            coap_set_status_code(response, BAD_REQUEST_4_00);
+            return;
+        }
+        if (coap_get_header_observe(request, &observe) && observe == 0) {
+            notify_selection = query.fields;
+            batch_start();
+        }
+        query.changed = changed & query.fields;
+    }
+
+    if (format == SENML_CBOR_CONTENT_FORMAT)
+        coap_chunked_respond(response, buffer, preferred_size, offset, SENML_CBOR_CONTENT_FORMAT, all_senml_cbor_generator, &query);
+    else
+        coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON, all_json_generator, &query);
+
+    if (offset == NULL)
+        notify_sent = query.included;
+
+    LOG_DBG("all resource GET handler called\n");
+}
+
+static void res_event_handler(void)
+{
+    notify_fields = changed & notify_selection;
+    if (notify_fields == 0)
+        return;
+
+    all_delivery.confirmable = (notify_fields & ((1 << ALL_RELAY) | (1 << ALL_ANTIDUST))) != 0;
+    notify_sent = notify_fields;
+    notify_delivery_notify(&all_delivery, &res_all);
+    if (notify_sent == 0) {
+        LOG_WARN("Notification too large, fields dropped: %u\n", notify_fields);
+        notify_sent = notify_fields;
+    }
+    changed &= ~notify_sent;
+
+    // what did not fit goes in the next notification
+    if (changed & notify_selection)
+        ctimer_set(&batch_timer, 0, batch_callback, NULL);
+
+    LOG_DBG("all resource event handler called\n");
+}
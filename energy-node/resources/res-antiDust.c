@@ -3,7 +3,12 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "profile.h"
 #include "random.h"
+#include "../res-all.h"
 
 #include "sys/log.h"
 #define LOG_MODULE "DUST"
@@ -23,32 +28,61 @@ void update_antiDust(enum antiDust_t newState)
 void antiDust_json_string(char* buffer)
 {
     // json of antiDust state
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE,
-            "{\"n\":\"antiDust\",\"v\":%d}",
-            antiDustState);
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"antiDust\",\"v\":");
+    p = fmt_int(p, antiDustState);
+    fmt_str(p, "}");
 }
 
+int antiDust_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 1);
+    p = senml_cbor_record(p, "antiDust", NULL, antiDustState);
+    return p - buffer;
+}
+
+// Notification delivery: state changes, confirmable
+notify_delivery_t antiDust_delivery = { true };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_post_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(antiDust_get, res_get_handler)
+LATENCY_HANDLER(antiDust_post, res_post_put_handler)
+LATENCY_EVENT_HANDLER(antiDust_event, res_event_handler)
+
 EVENT_RESOURCE(res_antiDust,
                 "title=\"antiDust control (on|off|alarm)\";rt=\"Control\";obs",
-                res_get_handler,
-                res_post_put_handler,
-                res_post_put_handler,
+                res_get_handler_timed,
+                res_post_put_handler_timed,
+                res_post_put_handler_timed,
                 NULL,                
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    antiDust_json_string((char *)buffer);
-
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    if (offset == NULL)
+        notify_delivery_prepare(&antiDust_delivery, response);
+
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, antiDust_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        antiDust_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("antiDust resource GET handler called\n");
 }
@@ -86,6 +120,7 @@ static void res_post_put_handler(coap_message_t *request, coap_message_t *respon
 
 static void res_event_handler(void)
 {
-    coap_notify_observers(&res_antiDust);
+    notify_delivery_notify(&antiDust_delivery, &res_antiDust);
+    all_changed(ALL_ANTIDUST);
     LOG_DBG("antiDust resource event handler called\n");
 }
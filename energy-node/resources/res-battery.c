@@ -3,12 +3,25 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "profile.h"
+#include "checkpoint.h"
+#include "../checkpoint-ids.h"
+#include "../res-all.h"
+#include "../res-history.h"
 #include "sys/clock.h"
 #include "sys/log.h"
 #define LOG_MODULE "BATT"
 #define LOG_LEVEL LOG_LEVEL_APP
 
-char* str(float value, char* output);
+// Notification policy: change of value and heartbeat, see notify-policy.h
+#define BATTERY_THRESHOLD 10.0 // in Wh
+#define BATTERY_PMAX (CLOCK_SECOND * 60)
+
+// triggered with the weather, see energy-node.c
+clock_time_t weather_sample_max();
 
 // Battery parameters
 #define BATTERY_CAPACITY 10000 // in Wh
@@ -19,6 +32,12 @@ float charge_rate = 0.0; // in W
 static unsigned long lastUpdateTime = 0;
 static unsigned long lastNotificationTime = 0;
 
+// Kept across reboots, see checkpoint.h: at most once a minute, the level
+// changes at every update while charging
+checkpoint_item_t battery_checkpoint = { CKPT_BATTERY, 1, CLOCK_SECOND * 60, {
+    { &battery_level, sizeof(battery_level) },
+} };
+
 static void update_battery_level()
 {
     if (lastUpdateTime == 0.0)
@@ -37,53 +56,102 @@ static void update_battery_level()
     }
 
     lastUpdateTime = currentTime;
+    checkpoint_save(&battery_checkpoint);
 
     if (charge_rate != 0.0)
     {
-        char level[16];
-        LOG_DBG("Battery level updated: %sWh\n", str(battery_level, level));
+        char level[FMT_FLOAT_BUF_SIZE];
+        LOG_DBG("Battery level updated: %sWh\n", fmt_float(battery_level, level));
     }
 }
 
 void battery_json_string(char* buffer)
 {
-    char buf[16];
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE, 
-            "{\"n\":\"battery\",\"v\":\"%s\"}", 
-            str(battery_level, buf));
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"battery\",\"v\":\"");
+    p = fmt_fixed(p, battery_level, FMT_PRECISION);
+    fmt_str(p, "\"}");
+}
+
+int battery_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 1);
+    p = senml_cbor_record(p, "battery", NULL, battery_level);
+    return p - buffer;
 }
 
+notify_policy_t battery_policy = { 1, { BATTERY_THRESHOLD }, 0, BATTERY_PMAX };
+
+// Notification delivery: telemetry, non-confirmable
+notify_delivery_t battery_delivery = { false };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(battery_get, res_get_handler)
+LATENCY_HANDLER(battery_post, res_post_handler)
+LATENCY_EVENT_HANDLER(battery_event, res_event_handler)
+
 EVENT_RESOURCE(res_battery,
                 "title=\"Battery data\";rt=\"Sensor\";obs",
-                res_get_handler,
-                NULL,
+                res_get_handler_timed,
+                res_post_handler_timed,
                 NULL,
                 NULL,
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    update_battery_level();
-    battery_json_string((char *)buffer);
+    if (offset == NULL)
+        notify_delivery_prepare(&battery_delivery, response);
+    coap_set_header_max_age(response, notify_policy_max_age(&battery_policy, weather_sample_max()));
 
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    update_battery_level();
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, battery_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        battery_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("Battery resource GET handler called\n");
 
-    char buf[16];
-    LOG_DBG("Battery level: %sWh\n", str(battery_level, buf));
+    char buf[FMT_FLOAT_BUF_SIZE];
+    LOG_DBG("Battery level: %sWh\n", fmt_float(battery_level, buf));
+}
+
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    if (notify_policy_configure(&battery_policy, request)) {
+        coap_set_status_code(response, CHANGED_2_04);
+        LOG_INFO("Battery notification policy: pmin=%lus, pmax=%lus\n",
+                 (unsigned long) (battery_policy.pmin / CLOCK_SECOND), (unsigned long) (battery_policy.pmax / CLOCK_SECOND));
+    } else {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+    }
 }
 
 static void res_event_handler(void)
 {
-    coap_notify_observers(&res_battery);
+    update_battery_level();
+    history_add(HISTORY_BATTERY, battery_level);
+    if (notify_policy_check(&battery_policy, &battery_level)) {
+        notify_delivery_notify(&battery_delivery, &res_battery);
+        all_changed(ALL_BATTERY);
+    }
 
     LOG_DBG("Battery resource event handler called\n");
 }
@@ -96,13 +164,14 @@ void updateChargeRate(float rate)
     if (charge_rate != 0.0 && 
         (battery_level < 0.1 * BATTERY_CAPACITY || battery_level > 0.9 * BATTERY_CAPACITY)) {
         if (currentTime - lastNotificationTime > 2) {
-            coap_notify_observers(&res_battery);
+            notify_delivery_notify(&battery_delivery, &res_battery);
+            all_changed(ALL_BATTERY);
             lastNotificationTime = currentTime;
         }
     }
         
     charge_rate = rate;
 
-    char charge_rate_str[16];
-    LOG_DBG("Charge rate set to: %sW\n", str(charge_rate, charge_rate_str));
+    char charge_rate_str[FMT_FLOAT_BUF_SIZE];
+    LOG_DBG("Charge rate set to: %sW\n", fmt_float(charge_rate, charge_rate_str));
 }
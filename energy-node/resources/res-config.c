@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "node-config.h"
+#include "adaptive-sampler.h"
+#include "residual-detector.h"
+#include "profile.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "CONFIG"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// external resources
+extern clock_time_t short_interval, antidust_interval, forecast_step;
+extern residual_detector_t prediction_detector;
+extern int32_t calibration_window;
+extern adaptive_sampler_t weather_samplers[3];
+void apply_config();
+
+// Control parameters of the energy node. The weather sampling bounds are
+// those of irr, copied to the other weather values.
+static const config_entry_t entries[] = {
+    { "short_interval", CONFIG_INTERVAL, &short_interval, 1, 3600 },
+    { "weather_smin", CONFIG_INTERVAL, &weather_samplers[0].min_interval, 1, 3600 },
+    { "weather_smax", CONFIG_INTERVAL, &weather_samplers[0].max_interval, 1, 3600 },
+    { "antidust_interval", CONFIG_INTERVAL, &antidust_interval, 1, 600 },
+    { "forecast_step", CONFIG_INTERVAL, &forecast_step, 1, 3600 },
+    { "anomaly_drift", CONFIG_FLOAT, &prediction_detector.drift, 0, 1 },
+    { "anomaly_limit", CONFIG_FLOAT, &prediction_detector.limit, 0.01, 10 },
+    { "anomaly_dust", CONFIG_FLOAT, &prediction_detector.warning, 0.01, 10 },
+    { "anomaly_alarm", CONFIG_FLOAT, &prediction_detector.alarm, 0.01, 10 },
+    { "calibration_window", CONFIG_INT, &calibration_window, 0, 1000 },
+};
+
+static bool config_check(void)
+{
+    return weather_samplers[0].min_interval <= weather_samplers[0].max_interval
+        && prediction_detector.drift < prediction_detector.limit
+        && prediction_detector.warning < prediction_detector.alarm;
+}
+
+static void config_changed(void)
+{
+    for (int i = 1; i < 3; i++) {
+        weather_samplers[i].min_interval = weather_samplers[0].min_interval;
+        weather_samplers[i].max_interval = weather_samplers[0].max_interval;
+    }
+    apply_config();
+}
+
+const config_t node_config = {
+    "config", entries, sizeof(entries) / sizeof(entries[0]), config_check, config_changed
+};
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(config_get, res_get_handler)
+LATENCY_HANDLER(config_put, res_put_handler)
+
+RESOURCE(res_config,
+         "title=\"Configuration (PUT name=value&..., SenML-CBOR)\";rt=\"Config\"",
+         res_get_handler_timed,
+         NULL,
+         res_put_handler_timed,
+         NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    config_get_handler(&node_config, request, response, buffer, preferred_size, offset);
+    LOG_DBG("config resource GET handler called\n");
+}
+
+static void res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    config_put_handler(&node_config, request, response);
+    LOG_DBG("config resource PUT handler called\n");
+}
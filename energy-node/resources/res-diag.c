@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "coap-chunked.h"
+#include "profile.h"
+#include "notify-policy.h"
+#include "adaptive-sampler.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "DIAG"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+#define DIAG_URI "diag"
+
+// external resources
+void prediction_json_string(char* buffer);
+void anomaly_json_string(char *buffer);
+void calibration_json_string(char *buffer);
+extern notify_policy_t weather_policy, battery_policy, gen_power_policy, forecast_policy;
+extern notify_delivery_t weather_delivery, battery_delivery, gen_power_delivery, all_delivery, relay_delivery, antiDust_delivery,
+    forecast_delivery;
+extern adaptive_sampler_t weather_samplers[3];
+extern profile_t profile_sensors, profile_gen_power, profile_prediction, profile_predict, profile_forecast;
+extern latency_t latency_weather_get, latency_weather_post, latency_weather_event,
+    latency_battery_get, latency_battery_post, latency_battery_event, latency_gen_power_get,
+    latency_gen_power_post, latency_gen_power_event, latency_relay_get, latency_relay_post,
+    latency_relay_event, latency_antiDust_get, latency_antiDust_post, latency_antiDust_event,
+    latency_all_get, latency_all_event, latency_history_get, latency_tasks_get,
+    latency_tasks_post, latency_config_get, latency_config_put, latency_forecast_get,
+    latency_forecast_post, latency_forecast_event, latency_model_get, latency_model_post,
+    latency_model_put, latency_diag_get;
+
+profile_t profile_json = { "json" }; // GET and notification payloads
+
+static void prediction_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[96];
+    prediction_json_string(buffer);
+    coap_chunked_put(out, buffer);
+}
+
+// residual detector of the predictions: last residual, EWMA mean and
+// deviation, CUSUM and thresholds, anti-dust cycles and alarms raised
+static void anomaly_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[256];
+    anomaly_json_string(buffer);
+    coap_chunked_put(out, buffer);
+}
+
+// correction of the model output: last raw and calibrated predictions,
+// gain, offset, pairs fitted and clean samples still to take
+static void calibration_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[128];
+    calibration_json_string(buffer);
+    coap_chunked_put(out, buffer);
+}
+
+// sent and suppressed notifications of the policy driven resources
+static void notify_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[48];
+    coap_chunked_put(out, "{\"n\":\"notify\",");
+    notify_policy_json(buffer, "weather", &weather_policy);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, ",");
+    notify_policy_json(buffer, "battery", &battery_policy);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, ",");
+    notify_policy_json(buffer, "gen_power", &gen_power_policy);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, ",");
+    notify_policy_json(buffer, "forecast", &forecast_policy);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, "}");
+}
+
+// notifications per message type and their delivery
+static void delivery_generator(coap_chunked_t *out, void *data)
+{
+    static const struct {
+        const char *name;
+        const notify_delivery_t *delivery;
+    } resources[] = {
+        { "weather", &weather_delivery },
+        { "battery", &battery_delivery },
+        { "gen_power", &gen_power_delivery },
+        { "all", &all_delivery },
+        { "relay", &relay_delivery },
+        { "antiDust", &antiDust_delivery },
+        { "forecast", &forecast_delivery },
+    };
+    char buffer[80];
+
+    coap_chunked_put(out, "{\"n\":\"delivery\"");
+    for (int i = 0; i < sizeof(resources) / sizeof(resources[0]); i++) {
+        notify_delivery_json(fmt_str(buffer, ","), resources[i].name, resources[i].delivery);
+        coap_chunked_put(out, buffer);
+    }
+    coap_chunked_put(out, "}");
+}
+
+// node times and CPU time of the control cycle branches and hot paths
+static void energest_generator(coap_chunked_t *out, void *data)
+{
+    static profile_t *const profiles[] = {
+        &profile_sensors, &profile_gen_power, &profile_prediction, &profile_predict, &profile_forecast, &profile_json, NULL
+    };
+    profile_energest_json(out, profiles);
+}
+
+// adaptive sampling of the weather: interval, mean and deviation of the rates
+static void sampler_generator(coap_chunked_t *out, void *data)
+{
+    static const char *const names[] = { "irr", "outTemp", "modTemp" };
+    char buffer[80];
+
+    coap_chunked_put(out, "{\"n\":\"sampler\"");
+    for (int i = 0; i < 3; i++) {
+        adaptive_sampler_json(fmt_str(buffer, ","), names[i], &weather_samplers[i]);
+        coap_chunked_put(out, buffer);
+    }
+    coap_chunked_put(out, "}");
+}
+
+// handler latency histograms
+static void latency_generator(coap_chunked_t *out, void *data)
+{
+    static latency_t *const latencies[] = {
+        &latency_weather_get, &latency_weather_post, &latency_weather_event, &latency_battery_get,
+        &latency_battery_post, &latency_battery_event, &latency_gen_power_get,
+        &latency_gen_power_post, &latency_gen_power_event, &latency_relay_get, &latency_relay_post,
+        &latency_relay_event, &latency_antiDust_get, &latency_antiDust_post,
+        &latency_antiDust_event, &latency_all_get, &latency_all_event, &latency_history_get,
+        &latency_tasks_get, &latency_tasks_post, &latency_config_get, &latency_config_put,
+        &latency_forecast_get, &latency_forecast_post, &latency_forecast_event,
+        &latency_model_get, &latency_model_post, &latency_model_put, &latency_diag_get, NULL
+    };
+    latency_json(out, latencies);
+}
+
+// sub-resources, served in Block2 chunks
+static const struct {
+    const char *name;
+    coap_chunked_generator_t generator;
+} diags[] = {
+    { "prediction", prediction_generator },
+    { "notify", notify_generator },
+    { "delivery", delivery_generator },
+    { "energest", energest_generator },
+    { "latency", latency_generator },
+    { "sampler", sampler_generator },
+    { "anomaly", anomaly_generator },
+    { "calibration", calibration_generator },
+};
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(diag_get, res_get_handler)
+
+PARENT_RESOURCE(res_diag,
+                "title=\"Diagnostics (diag/prediction|notify|delivery|energest|latency|sampler|anomaly|calibration)\";rt=\"Diag\"",
+                res_get_handler_timed,
+                NULL,
+                NULL,
+                NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    const char *uri = NULL;
+    int len = coap_get_header_uri_path(request, &uri);
+
+    // sub-resource name after "diag/"
+    const char *sub = uri + sizeof(DIAG_URI);
+    len -= sizeof(DIAG_URI);
+
+    for (int i = 0; i < sizeof(diags) / sizeof(diags[0]); i++) {
+        if (len == (int) strlen(diags[i].name) && strncmp(sub, diags[i].name, len) == 0) {
+            coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON, diags[i].generator, NULL);
+            coap_chunked_set_period_etag(response); // live counters
+            LOG_DBG("diag resource GET handler called\n");
+            return;
+        }
+    }
+
+    LOG_DBG("Unknown diagnostic resource: %.*s\n", len > 0 ? len : 0, sub);
+    coap_set_status_code(response, NOT_FOUND_4_04);
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "coap-chunked.h"
+#include "profile.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "FCAST"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// Solar power forecast: the weather trend is extrapolated over the next
+// FORECAST_STEPS steps and the model runs on all of them at once. The
+// consumers can charge the battery or cool the rooms ahead of a drop.
+#ifdef FORECAST_CONF_STEPS
+#define FORECAST_STEPS FORECAST_CONF_STEPS
+#else
+#define FORECAST_STEPS 8
+#endif
+
+#define FORECAST_STEP (CLOCK_SECOND * 60) // default of the config resource
+#define NUM_INPUT 3
+
+// Notification policy: change of the energy or of the lowest power
+#define FORECAST_THRESHOLD_WH 5.0
+#define FORECAST_THRESHOLD_W 100.0
+#define FORECAST_PMAX (CLOCK_SECOND * 120)
+
+// external resources
+unsigned long weather_revision();
+void weather_extrapolate(float *inputs, uint8_t n, clock_time_t step);
+void solar_power_evaluate_batch(const float *inputs, uint8_t n, float *predictions);
+extern profile_t profile_json; // serializers, see res-diag.c
+
+clock_time_t forecast_step = FORECAST_STEP; // see res-config.c
+
+static float forecast[FORECAST_STEPS]; // W at the end of each step
+static float forecast_energy = 0.0;    // Wh over the horizon
+static float forecast_min = 0.0;       // lowest power over the horizon
+static bool forecast_valid = false;
+static unsigned long forecast_revision = 0; // weather it was computed on
+static clock_time_t forecast_computed_step = 0;
+
+profile_t profile_forecast = { "forecast" };
+
+// New forecast, if the weather or the step changed since the last one
+void forecast_update()
+{
+    float inputs[FORECAST_STEPS * NUM_INPUT];
+
+    if (forecast_valid && forecast_revision == weather_revision() && forecast_computed_step == forecast_step)
+        return;
+
+    rtimer_clock_t start = profile_start();
+    weather_extrapolate(inputs, FORECAST_STEPS, forecast_step);
+    solar_power_evaluate_batch(inputs, FORECAST_STEPS, forecast);
+
+    forecast_energy = 0.0;
+    forecast_min = forecast[0];
+    for (int k = 0; k < FORECAST_STEPS; k++) {
+        forecast_energy += forecast[k];
+        if (forecast[k] < forecast_min)
+            forecast_min = forecast[k];
+    }
+    forecast_energy *= (float) forecast_step / CLOCK_SECOND / 3600.0;
+
+    forecast_revision = weather_revision();
+    forecast_computed_step = forecast_step;
+    forecast_valid = true;
+    profile_stop(&profile_forecast, start);
+}
+
+static void forecast_json_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[16 + FMT_FLOAT_BUF_SIZE];
+
+    char *p = fmt_str(buffer, "{\"n\":\"forecast\",\"step\":");
+    fmt_int(p, forecast_step / CLOCK_SECOND);
+    coap_chunked_put(out, buffer);
+    p = fmt_str(buffer, ",\"wh\":");
+    fmt_fixed(p, forecast_energy, 1);
+    coap_chunked_put(out, buffer);
+    p = fmt_str(buffer, ",\"min\":");
+    fmt_fixed(p, forecast_min, 1);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, ",\"p\":[");
+    for (int k = 0; k < FORECAST_STEPS; k++) {
+        fmt_fixed(fmt_str(buffer, k == 0 ? "" : ","), forecast[k], 1);
+        coap_chunked_put(out, buffer);
+    }
+    coap_chunked_put(out, "]}");
+}
+
+// forecast/step, forecast/wh, forecast/min, then forecast/p<k>
+static void forecast_senml_cbor_generator(coap_chunked_t *out, void *data)
+{
+    uint8_t buffer[32];
+    char name[8];
+
+    coap_chunked_write(out, buffer, senml_cbor_pack(buffer, 3 + FORECAST_STEPS) - buffer);
+    coap_chunked_write(out, buffer, senml_cbor_record(buffer, "forecast/", "step", (float) forecast_step / CLOCK_SECOND) - buffer);
+    coap_chunked_write(out, buffer, senml_cbor_record(buffer, NULL, "wh", forecast_energy) - buffer);
+    coap_chunked_write(out, buffer, senml_cbor_record(buffer, NULL, "min", forecast_min) - buffer);
+    for (int k = 0; k < FORECAST_STEPS; k++) {
+        fmt_int(fmt_str(name, "p"), k + 1);
+        coap_chunked_write(out, buffer, senml_cbor_record(buffer, NULL, name, forecast[k]) - buffer);
+    }
+}
+
+notify_policy_t forecast_policy = { 2, { FORECAST_THRESHOLD_WH, FORECAST_THRESHOLD_W }, 0, FORECAST_PMAX };
+
+// Notification delivery: telemetry, non-confirmable
+notify_delivery_t forecast_delivery = { false };
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_event_handler(void);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(forecast_get, res_get_handler)
+LATENCY_HANDLER(forecast_post, res_post_handler)
+LATENCY_EVENT_HANDLER(forecast_event, res_event_handler)
+
+EVENT_RESOURCE(res_forecast,
+                "title=\"Solar power forecast (step, wh, min, p)\";rt=\"Forecast\";obs",
+                res_get_handler_timed,
+                res_post_handler_timed,
+                NULL,
+                NULL,
+                res_event_handler_timed);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    if (offset == NULL)
+        notify_delivery_prepare(&forecast_delivery, response);
+    forecast_update();
+
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_chunked_respond(response, buffer, preferred_size, offset, SENML_CBOR_CONTENT_FORMAT,
+                             forecast_senml_cbor_generator, NULL);
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON,
+                             forecast_json_generator, NULL);
+        profile_stop(&profile_json, start);
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
+
+    LOG_DBG("forecast resource GET handler called\n");
+}
+
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    if (notify_policy_configure(&forecast_policy, request)) {
+        coap_set_status_code(response, CHANGED_2_04);
+        LOG_INFO("forecast notification policy: pmin=%lus, pmax=%lus\n",
+                 (unsigned long) (forecast_policy.pmin / CLOCK_SECOND), (unsigned long) (forecast_policy.pmax / CLOCK_SECOND));
+    } else {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+    }
+}
+
+static void res_event_handler(void)
+{
+    forecast_update();
+    float values[] = { forecast_energy, forecast_min };
+    if (notify_policy_check(&forecast_policy, values))
+        notify_delivery_notify(&forecast_delivery, &res_forecast);
+
+    LOG_DBG("forecast resource event handler called\n");
+}
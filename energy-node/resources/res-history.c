@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "coap-chunked.h"
+#include "profile.h"
+#include "sys/clock.h"
+#include "../res-history.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "HIST"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+#define HISTORY_URI "history"
+
+// RAM for the samples of each sensor: the oldest ones are dropped
+#ifdef HISTORY_CONF_BYTES
+#define HISTORY_BYTES HISTORY_CONF_BYTES
+#else
+#define HISTORY_BYTES 256
+#endif
+
+// Sample history of a sensor. The oldest sample is kept in full (base),
+// each following one as a record (time delta in seconds, value delta in
+// fixed point), both zigzag/varint encoded in a byte ring: a few bytes
+// per sample instead of eight.
+typedef struct {
+    const char *name;
+    int32_t scale;      // fixed point units per unit
+    uint8_t precision;  // decimal digits of the output
+    uint16_t count;     // samples, base included
+    unsigned long base_time;
+    int32_t base_value;
+    unsigned long last_time;
+    int32_t last_value;
+    uint16_t tail;      // first record after the base
+    uint16_t used;      // bytes of records
+    uint8_t ring[HISTORY_BYTES];
+} history_t;
+
+static history_t histories[HISTORY_COUNT] = {
+    [HISTORY_IRR] = { "irr", 1000, 3 },
+    [HISTORY_GEN_POWER] = { "gen_power", 10, 1 },
+    [HISTORY_BATTERY] = { "battery", 10, 1 },
+};
+
+static uint8_t ring_byte(const history_t *h, uint16_t pos)
+{
+    return h->ring[pos % HISTORY_BYTES];
+}
+
+// Reads the record at *pos: returns its size
+static uint8_t read_record(const history_t *h, uint16_t *pos, unsigned long *dt, int32_t *dv)
+{
+    uint8_t size = 0;
+    uint32_t value;
+
+    for (int field = 0; field < 2; field++) {
+        uint8_t b, shift = 0;
+        value = 0;
+        do {
+            b = ring_byte(h, *pos + size++);
+            value |= (uint32_t) (b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+
+        if (field == 0)
+            *dt = value;
+        else
+            *dv = (int32_t) (value >> 1) ^ -(int32_t) (value & 1); // zigzag
+    }
+    *pos = (*pos + size) % HISTORY_BYTES;
+    return size;
+}
+
+static uint8_t write_varint(uint8_t *out, uint32_t value)
+{
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = value;
+    return n;
+}
+
+// Oldest record becomes the base
+static void drop_oldest(history_t *h)
+{
+    unsigned long dt;
+    int32_t dv;
+    h->used -= read_record(h, &h->tail, &dt, &dv);
+    h->base_time += dt;
+    h->base_value += dv;
+    h->count--;
+}
+
+void history_add(enum history_sensor_t sensor, float value)
+{
+    history_t *h = &histories[sensor];
+    unsigned long now = clock_seconds();
+    float scaled = value * h->scale;
+    int32_t q = (int32_t) (scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+
+    if (h->count == 0) {
+        h->base_time = h->last_time = now;
+        h->base_value = h->last_value = q;
+        h->count = 1;
+        return;
+    }
+
+    uint8_t record[10];
+    int32_t dv = q - h->last_value;
+    uint8_t size = write_varint(record, now - h->last_time);
+    size += write_varint(record + size, ((uint32_t) dv << 1) ^ (uint32_t) (dv >> 31));
+
+    while (HISTORY_BYTES - h->used < size)
+        drop_oldest(h);
+
+    uint16_t head = (h->tail + h->used) % HISTORY_BYTES;
+    for (uint8_t i = 0; i < size; i++)
+        h->ring[(head + i) % HISTORY_BYTES] = record[i];
+    h->used += size;
+    h->count++;
+    h->last_time = now;
+    h->last_value = q;
+}
+
+typedef struct {
+    const history_t *history;
+    unsigned long since;
+} history_query_t;
+
+// {"n":"<name>","s":[[t,v],...]} with the samples after since
+static void history_json_generator(coap_chunked_t *out, void *data)
+{
+    const history_query_t *query = data;
+    const history_t *h = query->history;
+    unsigned long since = query->since;
+    char sample[12 + FMT_FLOAT_BUF_SIZE + 4];
+    unsigned long t = h->base_time;
+    int32_t v = h->base_value;
+    uint16_t pos = h->tail;
+    bool first = true;
+
+    coap_chunked_put(out, "{\"n\":\"");
+    coap_chunked_put(out, h->name);
+    coap_chunked_put(out, "\",\"s\":[");
+
+    for (uint16_t i = 0; i < h->count && !coap_chunked_full(out); i++) {
+        if (i > 0) {
+            unsigned long dt;
+            int32_t dv;
+            read_record(h, &pos, &dt, &dv);
+            t += dt;
+            v += dv;
+        }
+        if (t <= since)
+            continue;
+
+        char *p = fmt_str(sample, first ? "[" : ",[");
+        p = fmt_int(p, t);
+        p = fmt_str(p, ",");
+        p = fmt_fixed(p, (float) v / h->scale, h->precision);
+        fmt_str(p, "]");
+        coap_chunked_put(out, sample);
+        first = false;
+    }
+
+    coap_chunked_put(out, "]}");
+}
+
+// {"n":"history","now":..,"<name>":[count,oldest],...}
+static void history_summary_json_string(char* buffer)
+{
+    char *p = fmt_str(buffer, "{\"n\":\"history\",\"now\":");
+    p = fmt_int(p, clock_seconds());
+    for (int i = 0; i < HISTORY_COUNT; i++) {
+        p = fmt_str(p, ",\"");
+        p = fmt_str(p, histories[i].name);
+        p = fmt_str(p, "\":[");
+        p = fmt_int(p, histories[i].count);
+        p = fmt_str(p, ",");
+        p = fmt_int(p, histories[i].base_time);
+        p = fmt_str(p, "]");
+    }
+    fmt_str(p, "}");
+}
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(history_get, res_get_handler)
+
+PARENT_RESOURCE(res_history,
+                "title=\"Sample history (history, history/irr|gen_power|battery?since=)\";rt=\"History\"",
+                res_get_handler_timed,
+                NULL,
+                NULL,
+                NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    const char *uri = NULL;
+    int len = coap_get_header_uri_path(request, &uri);
+
+    // clock reference and ranges, fits a single block
+    if (len <= (int) strlen(HISTORY_URI)) {
+        history_summary_json_string((char *)buffer);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+        return;
+    }
+
+    // sensor name after "history/"
+    const char *sub = uri + sizeof(HISTORY_URI);
+    len -= sizeof(HISTORY_URI);
+
+    const history_t *h = NULL;
+    for (int i = 0; i < HISTORY_COUNT; i++)
+        if (len == (int) strlen(histories[i].name) && strncmp(sub, histories[i].name, len) == 0)
+            h = &histories[i];
+    if (h == NULL) {
+        LOG_DBG("Unknown history: %.*s\n", len > 0 ? len : 0, sub);
+        coap_set_status_code(response, NOT_FOUND_4_04);
+        return;
+    }
+
+    history_query_t query = { h, 0 };
+    // the query value is not NUL-terminated
+    const char *var = NULL;
+    int var_len = coap_get_query_variable(request, "since", &var);
+    if (var_len > 0) {
+        char since_str[12];
+        char *end;
+        if (var_len >= sizeof(since_str)) {
+            coap_set_status_code(response, BAD_REQUEST_4_00);
+            return;
+        }
+        memcpy(since_str, var, var_len);
+        since_str[var_len] = '\0';
+        query.since = strtoul(since_str, &end, 10);
+        if (since_str[0] < '0' || since_str[0] > '9' || *end != '\0') {
+            coap_set_status_code(response, BAD_REQUEST_4_00);
+            return;
+        }
+    }
+
+    // the oldest sample changes when samples are dropped: blocks of
+    // different ETags do not belong to the same representation
+    coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON, history_json_generator, &query);
+    coap_chunked_set_etag(response, h->base_time);
+
+    LOG_DBG("history resource GET handler called\n");
+}
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "cfs/cfs.h"
+#include "fixed-fmt.h"
+#include "coap-chunked.h"
+#include "checkpoint.h"
+#include "../checkpoint-ids.h"
+#include "profile.h"
+#include "../q8-net.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "MODEL"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// Solar power model uploaded to the node, so that a model retrained on
+// the data of a site does not need a new firmware. The image of the int8
+// model (see q8-net.h, quantize_model.py --binary) is PUT in Block1
+// blocks into one of two CFS slots, the one not in use, then checked
+// (CRC, layout, test vector) and swapped for the running model. The
+// check and the swap run in one handler call, without yielding: the
+// other handlers see either model. A failed image leaves the previous
+// model running. The slot in use is a checkpoint item, its model is
+// loaded again at boot.
+#ifdef MODEL_CONF_MAX_SIZE
+#define MODEL_MAX_SIZE MODEL_CONF_MAX_SIZE
+#else
+#define MODEL_MAX_SIZE 4096 // bytes of an image, kept in RAM once loaded
+#endif
+
+#define MODEL_BUILTIN -1 // slot of the model compiled in the firmware
+#define MODEL_NONE -2
+
+// external resources
+bool solar_power_model_install(Q8NetImage *model);
+void prediction_model_changed();
+
+static const char *const slot_files[2] = { "model.0", "model.1" };
+
+static uint32_t image[MODEL_MAX_SIZE / sizeof(uint32_t)]; // of the slot in use
+static Q8NetImage model;
+static int8_t model_slot = MODEL_BUILTIN;
+
+// upload in progress
+static int8_t upload_slot = MODEL_NONE;
+static uint32_t upload_size = 0;
+
+// Kept across reboots, see checkpoint.h
+checkpoint_item_t model_checkpoint = { CKPT_MODEL, 1, 0, {
+    { &model_slot, sizeof(model_slot) },
+} };
+
+// Loads the image of slot and runs it, the built-in model if it fails
+static bool load_slot(int8_t slot)
+{
+    // the image buffer of the running model is overwritten
+    solar_power_model_install(NULL);
+    if (slot == MODEL_BUILTIN)
+        return true;
+
+    int fd = cfs_open(slot_files[slot], CFS_READ);
+    if (fd < 0)
+        return false;
+    int size = cfs_read(fd, image, sizeof(image));
+    cfs_close(fd);
+
+    if (size <= 0 || q8_net_image_load(&model, (const uint8_t *) image, size) < 0) {
+        LOG_WARN("Model in %s is corrupted\n", slot_files[slot]);
+        return false;
+    }
+    return solar_power_model_install(&model);
+}
+
+static void set_slot(int8_t slot)
+{
+    if (slot == model_slot)
+        return;
+    model_slot = slot;
+    checkpoint_save(&model_checkpoint);
+    prediction_model_changed();
+}
+
+// Runs the model of slot, or the previous one again if it fails
+static bool use_slot(int8_t slot)
+{
+    if (!load_slot(slot)) {
+        if (slot == model_slot || !load_slot(model_slot))
+            set_slot(MODEL_BUILTIN);
+        return false;
+    }
+
+    set_slot(slot);
+    if (slot == MODEL_BUILTIN)
+        LOG_INFO("Running the built-in model\n");
+    else
+        LOG_INFO("Running model revision %lu from %s\n", (unsigned long) model.revision, slot_files[slot]);
+    return true;
+}
+
+// The model of the restored slot, after checkpoint_restore()
+void model_restore()
+{
+    if (model_slot == MODEL_BUILTIN)
+        return;
+    // the record passed its checks but may still hold any value
+    if (model_slot != 0 && model_slot != 1) {
+        LOG_WARN("Saved model slot %d is invalid, using the built-in one\n", model_slot);
+        set_slot(MODEL_BUILTIN);
+    } else if (!use_slot(model_slot)) {
+        LOG_WARN("Saved model rejected, using the built-in one\n");
+    }
+}
+
+static char *fmt_hex(char *out, uint32_t value)
+{
+    for (int8_t shift = 28; shift >= 0; shift -= 4)
+        *out++ = "0123456789abcdef"[(value >> shift) & 0xf];
+    *out = '\0';
+    return out;
+}
+
+// {"n":"model","slot":s,"rev":r,"crc":"<hex>","upload":bytes}, slot -1
+// and revision 0 for the built-in model
+static void model_json_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[48];
+    bool builtin = model_slot == MODEL_BUILTIN;
+
+    char *p = fmt_str(buffer, "{\"n\":\"model\",\"slot\":");
+    p = fmt_int(p, model_slot);
+    p = fmt_str(p, ",\"rev\":");
+    fmt_int(p, builtin ? 0 : model.revision);
+    coap_chunked_put(out, buffer);
+    p = fmt_str(buffer, ",\"crc\":\"");
+    p = fmt_hex(p, builtin ? 0 : model.crc);
+    p = fmt_str(p, "\",\"upload\":");
+    p = fmt_int(p, upload_size);
+    fmt_str(p, "}");
+    coap_chunked_put(out, buffer);
+}
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(model_get, res_get_handler)
+LATENCY_HANDLER(model_post, res_post_handler)
+LATENCY_HANDLER(model_put, res_put_handler)
+
+RESOURCE(res_model,
+         "title=\"Solar power model (PUT image in Block1, POST slot=-1|0|1)\";rt=\"Model\"",
+         res_get_handler_timed,
+         res_post_handler_timed,
+         res_put_handler_timed,
+         NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON, model_json_generator, NULL);
+    LOG_DBG("model resource GET handler called\n");
+}
+
+// Back to a model already uploaded, or to the built-in one
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    const char *var = NULL;
+    int len = coap_get_post_variable(request, "slot", &var);
+    int8_t slot = len == 2 && strncmp(var, "-1", 2) == 0 ? MODEL_BUILTIN
+                : len == 1 && (var[0] == '0' || var[0] == '1') ? var[0] - '0'
+                : MODEL_NONE;
+
+    // not the slot being uploaded
+    if (slot == MODEL_NONE || slot == upload_slot) {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+        return;
+    }
+    coap_set_status_code(response, use_slot(slot) ? CHANGED_2_04 : NOT_ACCEPTABLE_4_06);
+}
+
+// Image upload: each block is appended to the free slot, the last one
+// swaps the model. A request without Block1 is a single block. A block
+// sent again because its 2.31 was lost is acknowledged again, not
+// written twice.
+static void res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    const uint8_t *payload = NULL;
+    int len = coap_get_payload(request, &payload);
+    uint32_t num = 0, block_offset = 0;
+    uint8_t more = 0;
+    uint16_t size = 0;
+    bool block1 = coap_get_header_block1(request, &num, &more, &size, &block_offset);
+
+    if (block_offset == 0) {
+        upload_slot = model_slot == 0 ? 1 : 0;
+        upload_size = 0;
+        cfs_remove(slot_files[upload_slot]);
+    } else if (upload_slot != MODEL_NONE && more && block_offset + len == upload_size) {
+        coap_set_header_block1(response, num, more, size);
+        coap_set_status_code(response, CONTINUE_2_31);
+        return;
+    } else if (upload_slot == MODEL_NONE || block_offset != upload_size) {
+        coap_set_status_code(response, REQUEST_ENTITY_INCOMPLETE_4_08);
+        return;
+    }
+    if (upload_size + len > MODEL_MAX_SIZE) {
+        upload_slot = MODEL_NONE;
+        upload_size = 0;
+        coap_set_status_code(response, REQUEST_ENTITY_TOO_LARGE_4_13);
+        return;
+    }
+
+    int fd = cfs_open(slot_files[upload_slot], CFS_WRITE | CFS_APPEND);
+    int written = fd >= 0 ? cfs_write(fd, payload, len) : -1;
+    if (fd >= 0)
+        cfs_close(fd);
+    if (written != len) {
+        LOG_WARN("Write of %s failed\n", slot_files[upload_slot]);
+        upload_slot = MODEL_NONE;
+        upload_size = 0;
+        coap_set_status_code(response, INTERNAL_SERVER_ERROR_5_00);
+        return;
+    }
+    upload_size += len;
+
+    if (block1)
+        coap_set_header_block1(response, num, more, size);
+    if (more) {
+        coap_set_status_code(response, CONTINUE_2_31);
+        return;
+    }
+
+    int8_t slot = upload_slot;
+    LOG_INFO("Model image of %lu bytes received in %s\n", (unsigned long) upload_size, slot_files[slot]);
+    upload_slot = MODEL_NONE;
+    upload_size = 0;
+    coap_set_status_code(response, use_slot(slot) ? CHANGED_2_04 : NOT_ACCEPTABLE_4_06);
+}
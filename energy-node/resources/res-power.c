@@ -3,13 +3,22 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "profile.h"
 #include "random.h"
+#include "../res-all.h"
+#include "../res-history.h"
 #include "sys/log.h"
 #define LOG_MODULE "PW"
 #define LOG_LEVEL LOG_LEVEL_APP
 
+// Notification policy: change of value and heartbeat, see notify-policy.h
+#define GEN_POWER_THRESHOLD 30.0 // in W
+#define GEN_POWER_PMAX (CLOCK_SECOND * 30)
+
 // extern resources
-char* str(float value, char* output);
 enum status_t {STATUS_ON, STATUS_ANTIDUST, STATUS_ALARM};
 extern enum status_t energyNodeStatus;
 
@@ -23,8 +32,9 @@ float gen_power = 0.0; // in W
 bool defected = false; // true if the solar panel is defected
 
 float solar_power_predict();
+clock_time_t gen_power_trigger_interval();
 
-static void update_gen_power()
+void update_gen_power()
 {
     if (energyNodeStatus != STATUS_ON)
     {
@@ -50,47 +60,94 @@ static void update_gen_power()
                 (expected_power + step > MAX_POWER) ? MAX_POWER :
                 expected_power + step;
 
-    char gp[16];
-    LOG_DBG("Generated power updated: %sW (defected: %d)\n", str(gen_power, gp), defected);
+    char gp[FMT_FLOAT_BUF_SIZE];
+    LOG_DBG("Generated power updated: %sW (defected: %d)\n", fmt_float(gen_power, gp), defected);
 }
 
 void gen_power_json_string(char* buffer)
 {
-    char buf[16];
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE, 
-            "{\"n\":\"gen_power\",\"v\":\"%s\"}", 
-            str(gen_power, buf));
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"gen_power\",\"v\":\"");
+    p = fmt_fixed(p, gen_power, FMT_PRECISION);
+    fmt_str(p, "\"}");
+}
+
+int gen_power_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 1);
+    p = senml_cbor_record(p, "gen_power", NULL, gen_power);
+    return p - buffer;
 }
 
+notify_policy_t gen_power_policy = { 1, { GEN_POWER_THRESHOLD }, 0, GEN_POWER_PMAX };
+
+// Notification delivery: telemetry, non-confirmable
+notify_delivery_t gen_power_delivery = { false };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(gen_power_get, res_get_handler)
+LATENCY_HANDLER(gen_power_post, res_post_handler)
+LATENCY_EVENT_HANDLER(gen_power_event, res_event_handler)
+
 EVENT_RESOURCE(res_gen_power,
                 "title=\"gen_power data\";rt=\"Sensor\";obs",
-                res_get_handler,
-                NULL,
+                res_get_handler_timed,
+                res_post_handler_timed,
                 NULL,
                 NULL,                
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    gen_power_json_string((char *)buffer);
+    if (offset == NULL)
+        notify_delivery_prepare(&gen_power_delivery, response);
+    coap_set_header_max_age(response, notify_policy_max_age(&gen_power_policy, gen_power_trigger_interval()));
 
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, gen_power_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        gen_power_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+        LOG_DBG("Sending generated power: %sW\n", (char *)buffer);
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("gen_power resource GET handler called\n");
-    LOG_DBG("Sending generated power: %sW\n", (char *)buffer);
+}
+
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    if (notify_policy_configure(&gen_power_policy, request)) {
+        coap_set_status_code(response, CHANGED_2_04);
+        LOG_INFO("gen_power notification policy: pmin=%lus, pmax=%lus\n",
+                 (unsigned long) (gen_power_policy.pmin / CLOCK_SECOND), (unsigned long) (gen_power_policy.pmax / CLOCK_SECOND));
+    } else {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+    }
 }
 
 static void res_event_handler(void)
 {
     update_gen_power();
-    coap_notify_observers(&res_gen_power);
+    history_add(HISTORY_GEN_POWER, gen_power);
+    if (notify_policy_check(&gen_power_policy, &gen_power)) {
+        notify_delivery_notify(&gen_power_delivery, &res_gen_power);
+        all_changed(ALL_GEN_POWER);
+    }
     
     LOG_DBG("gen_power resource event handler called\n");
 }
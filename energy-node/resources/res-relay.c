@@ -3,6 +3,13 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "profile.h"
+#include "checkpoint.h"
+#include "../checkpoint-ids.h"
+#include "../res-all.h"
 #include "random.h"
 #include "sys/log.h"
 #define LOG_MODULE "RELAY"
@@ -12,7 +19,6 @@
 
 // external resources
 extern coap_endpoint_t hvac_node_endpoint;
-char* str(float value, char* output);
 void updateChargeRate(float rate);
 
 // Relay states. Destination of Solar Panel energy, souce of home energy.
@@ -24,6 +30,14 @@ static enum relay_home_t relay_home = RELAY_HOME_GRID; // Relay state for home
 float power_sp = 0.0; // Power from solar panel
 static float power_home = 0.0; // Power for home
 
+// Kept across reboots, see checkpoint.h
+checkpoint_item_t relay_checkpoint = { CKPT_RELAY, 1, 0, {
+    { &relay_sp, sizeof(relay_sp) },
+    { &relay_home, sizeof(relay_home) },
+    { &power_sp, sizeof(power_sp) },
+    { &power_home, sizeof(power_home) },
+} };
+
 void updateBatteryChargeRate()
 {
     float rate_battery = 0.0;
@@ -40,44 +54,82 @@ void update_relay(enum relay_sp_t new_relay_sp, enum relay_home_t new_relay_home
     relay_home = new_relay_home;
     power_sp = new_power_sp == -1.0 ? power_sp : new_power_sp;
     power_home = new_power_home == -1.0 ? power_home : new_power_home;
+    checkpoint_save(&relay_checkpoint);
 
     updateBatteryChargeRate();
 
-    char power_sp_str[16], power_home_str[16];
+    char power_sp_str[FMT_FLOAT_BUF_SIZE], power_home_str[FMT_FLOAT_BUF_SIZE];
     LOG_INFO("Relay state updated: relay_sp=%d, relay_home=%d, power_sp=%s, power_home=%s\n",
-             relay_sp, relay_home, str(power_sp, power_sp_str), str(power_home, power_home_str));
+             relay_sp, relay_home, fmt_float(power_sp, power_sp_str), fmt_float(power_home, power_home_str));
 }
 
 void relay_json_string(char* buffer)
 {
     // json of relays state and power consumption
-    char buf1[16], buf2[16];
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE,
-            "{\"n\":\"relay\",\"r_sp\":%d,\"r_h\":%d,\"p_sp\":%s,\"p_h\":%s}",
-            relay_sp, relay_home, str(power_sp, buf1), str(power_home, buf2));
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"relay\",\"r_sp\":");
+    p = fmt_int(p, relay_sp);
+    p = fmt_str(p, ",\"r_h\":");
+    p = fmt_int(p, relay_home);
+    p = fmt_str(p, ",\"p_sp\":");
+    p = fmt_fixed(p, power_sp, FMT_PRECISION);
+    p = fmt_str(p, ",\"p_h\":");
+    p = fmt_fixed(p, power_home, FMT_PRECISION);
+    fmt_str(p, "}");
 }
 
+int relay_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 4);
+    p = senml_cbor_record(p, "relay/", "r_sp", relay_sp);
+    p = senml_cbor_record(p, NULL, "r_h", relay_home);
+    p = senml_cbor_record(p, NULL, "p_sp", power_sp);
+    p = senml_cbor_record(p, NULL, "p_h", power_home);
+    return p - buffer;
+}
+
+// Notification delivery: state changes, confirmable
+notify_delivery_t relay_delivery = { true };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_post_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(relay_get, res_get_handler)
+LATENCY_HANDLER(relay_post, res_post_put_handler)
+LATENCY_EVENT_HANDLER(relay_event, res_event_handler)
+
 EVENT_RESOURCE(res_relay,
                 "title=\"Relay state\";rt=\"Control\";obs",
-                res_get_handler,
-                res_post_put_handler,
-                res_post_put_handler,
+                res_get_handler_timed,
+                res_post_put_handler_timed,
+                res_post_put_handler_timed,
                 NULL,                
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    relay_json_string((char *)buffer);
-
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    if (offset == NULL)
+        notify_delivery_prepare(&relay_delivery, response);
+
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, relay_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        relay_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("relay resource GET handler called\n");
 }
@@ -189,6 +241,7 @@ static void res_post_put_handler(coap_message_t *request, coap_message_t *respon
 
 static void res_event_handler(void)
 {
-    coap_notify_observers(&res_relay); 
+    notify_delivery_notify(&relay_delivery, &res_relay);
+    all_changed(ALL_RELAY);
     LOG_DBG("relay resource event handler called\n");
 }
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "coap-chunked.h"
+#include "profile.h"
+#include "task-sched.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "TASKS"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// {"n":"tasks","night":0|1,"wph":[expected,measured],"<name>":[interval,night_stretch,runs],...}
+static void tasks_json_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[48];
+    unsigned long seconds = task_sched_seconds();
+    uint32_t measured = seconds > 0 ? (uint64_t) task_sched_wakeups() * 3600 / seconds : 0;
+
+    char *p = fmt_str(buffer, "{\"n\":\"tasks\",\"night\":");
+    p = fmt_int(p, task_sched_is_night());
+    p = fmt_str(p, ",\"wph\":[");
+    p = fmt_int(p, task_sched_expected_wakeups());
+    p = fmt_str(p, ",");
+    p = fmt_int(p, measured);
+    fmt_str(p, "]");
+    coap_chunked_put(out, buffer);
+
+    const task_t *task;
+    for (uint8_t i = 0; (task = task_sched_task(i)) != NULL; i++) {
+        p = fmt_str(buffer, ",\"");
+        p = fmt_str(p, task->name);
+        p = fmt_str(p, "\":[");
+        p = fmt_int(p, task->interval / CLOCK_SECOND);
+        p = fmt_str(p, ",");
+        p = fmt_int(p, task->night_stretch);
+        p = fmt_str(p, ",");
+        p = fmt_int(p, task->runs);
+        fmt_str(p, "]");
+        coap_chunked_put(out, buffer);
+    }
+    coap_chunked_put(out, "}");
+}
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(tasks_get, res_get_handler)
+LATENCY_HANDLER(tasks_post, res_post_handler)
+
+RESOURCE(res_tasks,
+         "title=\"Periodic tasks (POST name=sensors|gen_power|prediction&night=)\";rt=\"Tasks\"",
+         res_get_handler_timed,
+         res_post_handler_timed,
+         NULL,
+         NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON, tasks_json_generator, NULL);
+    LOG_DBG("tasks resource GET handler called\n");
+}
+
+// Number from the POST payload, NUL-terminated
+static bool get_number(coap_message_t *request, const char *name, long *value)
+{
+    const char *var = NULL;
+    char str[12];
+    char *end;
+    int len = coap_get_post_variable(request, name, &var);
+
+    if (len <= 0 || len >= sizeof(str))
+        return false;
+    memcpy(str, var, len);
+    str[len] = '\0';
+    *value = strtol(str, &end, 10);
+    return *end == '\0';
+}
+
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    const char *name = NULL;
+    int len = coap_get_post_variable(request, "name", &name);
+    task_t *task = len > 0 ? task_sched_find(name, len) : NULL;
+
+    if (task == NULL) {
+        coap_set_status_code(response, NOT_FOUND_4_04);
+        return;
+    }
+
+    // Only the night stretch: the intervals are owned elsewhere (short_interval
+    // in /config for gen_power and prediction, the adaptive weather sampling
+    // for sensors) and would be overwritten on the next apply_config() or run
+    long night_stretch;
+
+    if (!get_number(request, "night", &night_stretch)
+        || night_stretch < 0 || night_stretch > UINT8_MAX) {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+        return;
+    }
+
+    task_sched_set_interval(task, task->interval, night_stretch);
+    coap_set_status_code(response, CHANGED_2_04);
+    LOG_INFO("Task %s: night stretch=%ld\n", task->name, night_stretch);
+}
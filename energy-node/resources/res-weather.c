@@ -3,18 +3,79 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "adaptive-sampler.h"
+#include "profile.h"
 #include "random.h"
+#include "../q8-net.h" // model images, see res-model.c
+#include "../res-all.h"
+#include "../res-history.h"
 
-// Solar Power Prediction
+// Solar Power Prediction: int8 quantized model, pruned float model or emlearn float model
+#ifdef SOLAR_POWER_MODEL_CONF_Q8
+#define SOLAR_POWER_MODEL_Q8 SOLAR_POWER_MODEL_CONF_Q8
+#else
+#define SOLAR_POWER_MODEL_Q8 0
+#endif
+
+#ifdef SOLAR_POWER_MODEL_CONF_SPARSE
+#define SOLAR_POWER_MODEL_SPARSE SOLAR_POWER_MODEL_CONF_SPARSE
+#else
+#define SOLAR_POWER_MODEL_SPARSE 0
+#endif
+
+#if SOLAR_POWER_MODEL_Q8
+#include "../solar-power-model-q8.h"
+// the built-in model or one uploaded to the node, see res-model.c
+static const Q8Net *solar_power_net = &solar_power_prediction_q8;
+#define solar_power_model_regress1(features, n_features) \
+    q8_net_regress1(solar_power_net, features, n_features)
+#define solar_power_model_regress(features, n_features, n_samples, outputs) /* batched */ \
+    q8_net_regress(solar_power_net, features, n_features, n_samples, \
+                   solar_power_prediction_q8_batch1, solar_power_prediction_q8_batch2, outputs)
+#elif SOLAR_POWER_MODEL_SPARSE
+#include "../solar-power-model-sparse.h"
+#define solar_power_model_regress1 solar_power_prediction_sparse_regress1
+#else
 #include "../solar-power-model.h"
+#define solar_power_model_regress1 solar_power_prediction_regress1
+#endif
 #define NUM_INPUT 3
 #define MAX_POWER 3000.0
+#define MODEL_TEST_TOLERANCE 0.1 // W, between a model and its test vector
 
 #include "sys/log.h"
 #define LOG_MODULE "WEATH"
 #define LOG_LEVEL LOG_LEVEL_APP
 
-// Generated weather parameters
+// Notification policy: change of value and heartbeat, see notify-policy.h
+#define WEATHER_THRESHOLD_IRR 0.05
+#define WEATHER_THRESHOLD_TEMP 0.5
+#define WEATHER_PMAX (CLOCK_SECOND * 60)
+
+// Adaptive sampling, see adaptive-sampler.h: the weather is sampled when
+// a value may have moved by a notification threshold
+#ifdef WEATHER_CONF_SAMPLE_MIN
+#define WEATHER_SAMPLE_MIN WEATHER_CONF_SAMPLE_MIN
+#else
+#define WEATHER_SAMPLE_MIN (CLOCK_SECOND * 5)
+#endif
+#ifdef WEATHER_CONF_SAMPLE_MAX
+#define WEATHER_SAMPLE_MAX WEATHER_CONF_SAMPLE_MAX
+#else
+#define WEATHER_SAMPLE_MAX WEATHER_PMAX // heartbeat still on time
+#endif
+
+// Generated weather parameters: random walks whose steps grow with the
+// time since the previous sample, MAX_*_DIFF every WEATHER_STEP_PERIOD at
+// most, so that the weather moves at the same pace however often it is
+// sampled (a step per sample would look slower at longer intervals, and
+// the adaptive sampler would stretch them up to its maximum). The walks
+// stay within their ranges: the models are exact or validated only there
+// (see prune_model.py and quantize_model.py).
+#define WEATHER_STEP_PERIOD (CLOCK_SECOND * 15)
 #define MIN_IRRADIATION 0.0
 #define MAX_IRRADIATION 1.5
 #define MAX_IRR_DIFF 0.05
@@ -27,93 +88,326 @@
 #define MAX_MODULE_TEMPERATURE 65.0
 #define MAX_MODULE_TEMP_DIFF 0.5
 
-char* str(float value, char* output);
+// Weather trend of the forecast, see weather_extrapolate()
+#ifdef WEATHER_CONF_TREND_DAMPING
+#define WEATHER_TREND_DAMPING WEATHER_CONF_TREND_DAMPING
+#else
+#define WEATHER_TREND_DAMPING 0.8f // share of the rate kept at each step
+#endif
 
 static float irradiation = (MIN_IRRADIATION + MAX_IRRADIATION) / 2.0;
 static float out_temperature = (MIN_OUT_TEMPERATURE + MAX_OUT_TEMPERATURE) / 2.0;
 static float module_temperature = (MIN_MODULE_TEMPERATURE + MAX_MODULE_TEMPERATURE) / 2.0;
 
-// Callable from outside: expected power prediction
-float solar_power_predict()
+// Prediction cache: the model runs only when the weather inputs change
+static unsigned long weather_version = 0; // incremented when the weather changes
+static unsigned long prediction_version = 0;
+static bool prediction_valid = false;
+static float prediction_cache = 0.0;
+static unsigned long prediction_hits = 0;
+static unsigned long prediction_misses = 0;
+
+// Model evaluation on the current weather, without cache
+float solar_power_evaluate()
 {
     float inputs[NUM_INPUT];
     inputs[0] = out_temperature;
     inputs[1] = module_temperature;
     inputs[2] = irradiation;
 
-    float prediction = solar_power_prediction_regress1(inputs, NUM_INPUT);
+    float prediction = solar_power_model_regress1(inputs, NUM_INPUT);
     
     if (prediction < 0.0) {
         LOG_ERR("Negative power prediction, returning 0.0\n");
-        return 0.0;
+        prediction = 0.0;
     }
-
-    if (prediction > MAX_POWER) {
+    else if (prediction > MAX_POWER) {
         LOG_ERR("Power prediction exceeds maximum limit, returning MAX_POWER\n");
-        return MAX_POWER;
+        prediction = MAX_POWER;
     }
-    
+
     return prediction;
 }
 
+// Model evaluation on n rows of NUM_INPUT inputs, see res-forecast.c
+void solar_power_evaluate_batch(const float *inputs, uint8_t n, float *predictions)
+{
+#ifdef solar_power_model_regress
+    solar_power_model_regress(inputs, NUM_INPUT, n, predictions);
+#else
+    for (uint8_t k = 0; k < n; k++)
+        predictions[k] = solar_power_model_regress1(inputs + k * NUM_INPUT, NUM_INPUT);
+#endif
+
+    for (uint8_t k = 0; k < n; k++) {
+        float prediction = predictions[k];
+        predictions[k] = prediction < 0.0 ? 0.0 : prediction > MAX_POWER ? MAX_POWER : prediction;
+    }
+}
+
+// Replaces the model, NULL: back to the built-in one. A loaded model must
+// take the weather inputs, fit the activation buffers of the built-in one
+// and give its test output. Returns false if not, the model is unchanged.
+bool solar_power_model_install(Q8NetImage *model)
+{
+#if SOLAR_POWER_MODEL_Q8
+    const Q8Net *builtin = &solar_power_prediction_q8;
+
+    if (model == NULL) {
+        solar_power_net = builtin;
+    } else {
+        Q8Net *net = &model->net;
+        if (net->layers[0].n_inputs != NUM_INPUT)
+            return false;
+        for (int32_t l = 0; l < net->n_layers; l++)
+            if (net->layers[l].n_outputs > builtin->activations_length)
+                return false;
+        net->activations1 = builtin->activations1;
+        net->activations2 = builtin->activations2;
+        net->activations_length = builtin->activations_length;
+
+        float output = q8_net_regress1(net, model->test_features, NUM_INPUT);
+        if (!(fabsf(output - model->test_output) <= MODEL_TEST_TOLERANCE)) {
+            LOG_WARN("Model test vector failed\n");
+            return false;
+        }
+        solar_power_net = net;
+    }
+    weather_version++; // invalidate the cached prediction and forecast
+    return true;
+#else
+    return model == NULL; // float models are compiled in
+#endif
+}
+
+profile_t profile_predict = { "predict" };
+
+// Callable from outside: expected power prediction
+float solar_power_predict()
+{
+    rtimer_clock_t start = profile_start();
+
+    if (prediction_valid && prediction_version == weather_version) {
+        prediction_hits++;
+        profile_stop(&profile_predict, start);
+        return prediction_cache;
+    }
+    prediction_misses++;
+
+    float prediction = solar_power_evaluate();
+
+    prediction_cache = prediction;
+    prediction_version = weather_version;
+    prediction_valid = true;
+
+    profile_stop(&profile_predict, start);
+    return prediction;
+}
+
+void prediction_json_string(char* buffer)
+{
+    char *p = fmt_str(buffer, "{\"n\":\"prediction\",\"v\":\"");
+    p = fmt_fixed(p, prediction_cache, FMT_PRECISION);
+    p = fmt_str(p, "\",\"hit\":");
+    p = fmt_int(p, prediction_hits);
+    p = fmt_str(p, ",\"miss\":");
+    p = fmt_int(p, prediction_misses);
+    fmt_str(p, "}");
+}
+
+static float clamp(float value, float min, float max)
+{
+    return value < min ? min : value > max ? max : value;
+}
+
 static void update_weather()
 {
+    static clock_time_t last_update;
+    static bool updated = false;
+    clock_time_t now = clock_time();
+    float periods = updated ? (float) (now - last_update) / WEATHER_STEP_PERIOD : 1.0;
+    last_update = now;
+    updated = true;
+
     float step_irr = (float) random_rand() / (float) RANDOM_RAND_MAX * 2.0;
     step_irr -= 1.0; // range [-1.0, 1.0]
-    step_irr *= MAX_IRR_DIFF;
+    step_irr *= MAX_IRR_DIFF * periods;
     irradiation += step_irr;
 
     float step_temp = (float) random_rand() / (float) RANDOM_RAND_MAX * 2.0;
     step_temp -= 1.0; // range [-1.0, 1.0]
-    step_temp *= MAX_TEMP_DIFF;
+    step_temp *= MAX_TEMP_DIFF * periods;
     out_temperature += step_temp;
 
     float step_module_temp = (float) random_rand() / (float) RANDOM_RAND_MAX * 2.0;
     step_module_temp -= 1.0; // range [-1.0, 1.0]
-    step_module_temp *= MAX_MODULE_TEMP_DIFF;
+    step_module_temp *= MAX_MODULE_TEMP_DIFF * periods;
     module_temperature += step_module_temp;
 
-    char irradiation_str[16], out_temperature_str[16], module_temperature_str[16];
+    irradiation = clamp(irradiation, MIN_IRRADIATION, MAX_IRRADIATION);
+    out_temperature = clamp(out_temperature, MIN_OUT_TEMPERATURE, MAX_OUT_TEMPERATURE);
+    module_temperature = clamp(module_temperature, MIN_MODULE_TEMPERATURE, MAX_MODULE_TEMPERATURE);
+
+    if (step_irr != 0.0 || step_temp != 0.0 || step_module_temp != 0.0)
+        weather_version++; // invalidate the cached prediction
+
+    char irradiation_str[FMT_FLOAT_BUF_SIZE], out_temperature_str[FMT_FLOAT_BUF_SIZE], module_temperature_str[FMT_FLOAT_BUF_SIZE];
     LOG_DBG("New weather values: Irradiation=%s, Out Temperature=%s, Module Temperature=%s\n",
-            str(irradiation, irradiation_str), str(out_temperature, out_temperature_str), str(module_temperature, module_temperature_str));
+            fmt_float(irradiation, irradiation_str), fmt_float(out_temperature, out_temperature_str), fmt_float(module_temperature, module_temperature_str));
+}
+
+float weather_irradiation()
+{
+    return irradiation;
+}
+
+// Changes with every new weather sample
+unsigned long weather_revision()
+{
+    return weather_version;
 }
 
 void weather_json_string(char* buffer)
 {
-    char buf1[16], buf2[16], buf3[16];
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE,
-            "{\"n\":\"weather\",\"irr\":%s,\"outTemp\":%s,\"modTemp\":%s}",
-            str(irradiation, buf1), str(out_temperature, buf2), str(module_temperature, buf3));
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"weather\",\"irr\":");
+    p = fmt_fixed(p, irradiation, FMT_PRECISION);
+    p = fmt_str(p, ",\"outTemp\":");
+    p = fmt_fixed(p, out_temperature, FMT_PRECISION);
+    p = fmt_str(p, ",\"modTemp\":");
+    p = fmt_fixed(p, module_temperature, FMT_PRECISION);
+    fmt_str(p, "}");
+}
+
+int weather_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 3);
+    p = senml_cbor_record(p, "weather/", "irr", irradiation);
+    p = senml_cbor_record(p, NULL, "outTemp", out_temperature);
+    p = senml_cbor_record(p, NULL, "modTemp", module_temperature);
+    return p - buffer;
+}
+
+adaptive_sampler_t weather_samplers[3] = {
+    { WEATHER_THRESHOLD_IRR, WEATHER_SAMPLE_MIN, WEATHER_SAMPLE_MAX },
+    { WEATHER_THRESHOLD_TEMP, WEATHER_SAMPLE_MIN, WEATHER_SAMPLE_MAX },
+    { WEATHER_THRESHOLD_TEMP, WEATHER_SAMPLE_MIN, WEATHER_SAMPLE_MAX },
+};
+static clock_time_t sample_interval = WEATHER_SAMPLE_MIN;
+
+// Interval to the next weather sample, the shortest of the values
+clock_time_t weather_sample_interval()
+{
+    return sample_interval;
+}
+
+// Longest interval between weather samples, the sensors trigger
+clock_time_t weather_sample_max()
+{
+    return weather_samplers[0].max_interval;
 }
 
+// Model inputs for the next n steps: each value follows the rate of
+// change of its sampler (see adaptive-sampler.h), damped at each step so
+// that a transient does not run away, within the range of the weather.
+void weather_extrapolate(float *inputs, uint8_t n, clock_time_t step)
+{
+    // model input order, samplers: irr, outTemp, modTemp
+    static const uint8_t sampler[NUM_INPUT] = { 1, 2, 0 };
+    static const float min[NUM_INPUT] = { MIN_OUT_TEMPERATURE, MIN_MODULE_TEMPERATURE, MIN_IRRADIATION };
+    static const float max[NUM_INPUT] = { MAX_OUT_TEMPERATURE, MAX_MODULE_TEMPERATURE, MAX_IRRADIATION };
+    const float values[NUM_INPUT] = { out_temperature, module_temperature, irradiation };
+    float seconds = (float) step / CLOCK_SECOND;
+    float trend = 0.0f, damping = 1.0f;
+
+    for (uint8_t k = 0; k < n; k++) {
+        damping *= WEATHER_TREND_DAMPING;
+        trend += damping * seconds;
+        for (uint8_t i = 0; i < NUM_INPUT; i++) {
+            float value = values[i] + weather_samplers[sampler[i]].mean * trend;
+            inputs[k * NUM_INPUT + i] = value < min[i] ? min[i] : value > max[i] ? max[i] : value;
+        }
+    }
+}
+
+notify_policy_t weather_policy = { 3, { WEATHER_THRESHOLD_IRR, WEATHER_THRESHOLD_TEMP, WEATHER_THRESHOLD_TEMP }, 0, WEATHER_PMAX };
+
+// Notification delivery: telemetry, non-confirmable
+notify_delivery_t weather_delivery = { false };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(weather_get, res_get_handler)
+LATENCY_HANDLER(weather_post, res_post_handler)
+LATENCY_EVENT_HANDLER(weather_event, res_event_handler)
+
 EVENT_RESOURCE(res_weather,
                 "title=\"Weather data (irr, outTemp, modTemp)\";rt=\"Sensor[3]\";obs",
-                res_get_handler,
-                NULL,
+                res_get_handler_timed,
+                res_post_handler_timed,
                 NULL,
                 NULL,                
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    weather_json_string((char *)buffer);
+    if (offset == NULL)
+        notify_delivery_prepare(&weather_delivery, response);
+    coap_set_header_max_age(response, notify_policy_max_age(&weather_policy, weather_sample_max()));
 
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, weather_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        weather_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("Weather resource GET handler called\n");
 }
 
+static void res_post_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    // the sampling bounds are in the config resource, checked and saved
+    if (notify_policy_configure(&weather_policy, request)) {
+        coap_set_status_code(response, CHANGED_2_04);
+        LOG_INFO("Weather notification policy: pmin=%lus, pmax=%lus\n",
+                 (unsigned long) (weather_policy.pmin / CLOCK_SECOND), (unsigned long) (weather_policy.pmax / CLOCK_SECOND));
+    } else {
+        coap_set_status_code(response, BAD_REQUEST_4_00);
+    }
+}
+
 static void res_event_handler(void)
 {
     update_weather();
-    coap_notify_observers(&res_weather);
+    history_add(HISTORY_IRR, irradiation);
+    float values[] = { irradiation, out_temperature, module_temperature };
+
+    sample_interval = weather_samplers[0].max_interval;
+    for (int i = 0; i < 3; i++) {
+        clock_time_t interval = adaptive_sampler_update(&weather_samplers[i], values[i], ADAPTIVE_SAMPLER_NO_BOUNDARY);
+        if (interval < sample_interval)
+            sample_interval = interval;
+    }
+
+    if (notify_policy_check(&weather_policy, values)) {
+        notify_delivery_notify(&weather_delivery, &res_weather);
+        all_changed(ALL_WEATHER);
+    }
     
     LOG_DBG("Weather resource event handler called\n");
 }
@@ -0,0 +1,38 @@
+// Generated by ML-expected-solar-power/quantize_model.py, do not edit.
+// int8 weights, int16 activations, one scale per layer.
+// Max error vs float model on the weather range: 27.818 W
+#include "q8-net.h"
+static const int32_t solar_power_prediction_q8_layer_0_biases[21] = { 67661, 4173, -22, -28474, -30250, 0, 0, 0, 0, 3517, -1962, -3441, 0, 9354, 0, 0, -8687, 3769, 0, -39110, 0 };
+static const int8_t solar_power_prediction_q8_layer_0_weights[63] = { 78, -77, -30, 23, 68, 27, -17, 30, 23, 18, 40, -26, 21, 9, -24, -30, -94, 2, -16, -63, 3, 22, -76, -3, -70, -36, 0, 59, -59, 20, -12, 23, 27, 61, -127, -2, 11, -88, 2, 60, 4, 22, -42, 26, 0, 40, -87, 2, 32, 74, 24, 64, -31, -29, 1, -53, -2, 22, 25, -24, -30, 0, 3 };
+static const int32_t solar_power_prediction_q8_layer_1_biases[30] = { 0, 36864, 13729, 39467, -1766, -5481, 22276, 115552, 21677, -3303, 21037, -6830, -3632, 0, 14893, 9672, 10431, 0, 0, 20294, 15122, 0, 0, 0, -2825, 21420, 31642, 25518, 37832, 37734 };
+static const int8_t solar_power_prediction_q8_layer_1_weights[630] = { 30, -42, 33, 37, -40, 41, 35, 28, 26, -24, -12, 42, -25, -4, 9, -35, -42, -6, -31, -2, -9, 1, 0, 35, -63, -61, 1, -27, -13, -35, 55, 9, 15, -14, 22, 3, 3, -21, -58, 21, -3, 22, -63, 41, 24, -15, -3, 3, 22, -6, -10, 32, 75, 30, -15, 31, 29, 14, 48, -80, -14, -30, 42, -19, 8, 6, -53, -92, -19, -33, 24, 35, 94, 82, -31, -43, 60, -11, 16, -6, -18, -9, -55, 38, -37, -11, -22, -7, -24, 1, -29, -18, -11, -23, -12, 36, 36, 36, 15, 18, -2, 15, 31, -16, -43, 32, -23, -6, 22, -35, 34, 40, -32, -2, -12, 13, 31, 29, -14, 9, -23, -8, -11, 40, 17, 9, -15, 59, 36, -56, -41, 23, 19, -38, -2, 113, 3, -28, 31, 11, -12, 1, 3, -68, 2, 18, -22, 120, -5, -125, -6, 73, 30, 3, -38, -32, 39, -127, -11, 26, -23, -27, 41, -52, 86, -5, 6, 37, -31, 61, -21, -76, -22, 26, 8, -14, 14, 108, 30, -12, -13, 60, 39, 14, 42, -35, -14, -48, -26, -10, -1, -42, -9, -34, 4, 41, 25, -23, -12, -30, -10, 10, -3, -25, 10, 23, 36, 27, -43, -33, -59, 44, 5, -56, -20, 15, 3, 26, 19, 105, 13, 37, -27, 41, 31, -40, 39, -43, -18, 3, 31, -2, -15, -43, 14, 20, -1, 18, -21, 38, -49, 11, 19, 27, -17, -27, 13, 13, -16, 19, 2, -25, 25, -4, -39, -44, 15, 14, 32, -2, -25, -3, -23, -35, 6, -27, 43, 36, 1, 6, 21, 4, -41, -21, -27, 1, -30, 1, -33, 3, -35, 13, 13, 18, -3, 32, 41, 23, 9, -43, -42, -17, 18, -20, -46, 69, 68, -81, -37, 36, -43, -23, -15, 37, 40, 11, -40, 60, -9, -10, -1, -7, -37, -54, 41, -50, 50, -12, -69, -37, -22, -9, -12, -21, 96, 40, 21, -43, 42, 41, 4, 24, -76, 43, -42, 27, -2, 31, 20, -19, -86, -2, 38, 1, 18, 101, 85, 3, 39, 43, -36, -18, 38, -84, -5, -46, 0, -17, 17, 36, -10, 38, 42, 14, -5, 24, -20, 12, 2, 15, -32, -37, 43, -5, -8, 10, -42, 25, 43, -15, -22, 42, -15, -17, -42, -14, 32, -29, 40, -14, 32, -38, -42, 28, -40, -41, 23, 3, -24, -48, -6, 28, -52, -53, 38, 43, -18, -11, 88, 16, -19, -2, 28, 25, -22, 36, -34, -37, -5, 22, 14, -32, 9, 108, 38, -2, -31, 0, -33, -12, -79, 7, -5, -15, -18, -39, -11, 87, 14, 74, 3, 37, -15, -16, -40, 24, 30, 14, -26, -22, -35, -25, -4, -39, -39, 33, 41, 9, 38, 21, -30, 18, 19, -17, -14, -24, -21, -37, 19, 37, -39, 38, -19, -9, -26, 6, 17, -14, -39, -8, -35, 19, 37, -3, -14, 15, -13, -31, -5, -11, 42, 25, -22, -1, 32, 42, 0, 18, 40, -9, -15, -21, -13, -23, 19, 35, -21, -13, -40, -27, 27, -40, -43, 6, -22, 0, -36, 19, 33, -10, -45, 13, 33, -31, -36, 1, 53, 38, -18, -64, -1, 7, 21, -27, 83, 50, 17, 10, 28, 12, -12, -3, -63, -34, 13, -10, -65, -8, -15, -43, -82, -6, 12, 39, 36, 114, 66, 22, -32, 1, 28, -35, 22, -21, -14, 19, 13, -7, 7, -37, -54, -83, -42, 41, 17, -12, 56, 8, -24, 31, 34, -41, -36, -12, -2, -43, -7, -12, -49, 10, -6, -14, -78, -44, 39, -24, 39, 96, 23, 4, -30, 50, -27, -37, -9, -52, 31, -38, 15, 39, -18, 2, -39, -28, -39, -42, -43, -35, 75, 13, -16, 11, 1, -22, -3, 25, -78, 16, -81, -20 };
+static const int32_t solar_power_prediction_q8_layer_2_biases[30] = { -6225, 75047, 15268, 21125, 0, 0, 16044, 28271, 21356, 5010, 17197, -2854, 0, 20749, 18009, 9600, 18477, 5384, 19665, -2432, 18348, 13402, -6261, 16311, 19615, -2955, 20637, 0, 69945, 0 };
+static const int8_t solar_power_prediction_q8_layer_2_weights[900] = { -1, 13, 7, 1, -3, 17, -9, 10, -32, -12, -25, -24, -5, 18, -12, -1, -19, -20, 8, -2, 32, 13, 15, -9, 8, 10, -17, 22, 3, 4, 10, -2, -65, -100, -9, -14, 5, 34, -3, -20, -28, -12, 16, 18, -47, -81, -40, -10, -15, -4, 25, 15, -12, -12, 10, 0, 2, 35, -41, -6, -15, 16, 0, 48, -8, -21, 15, -9, 33, -9, 17, -15, -13, -13, 22, 13, 25, -8, 13, 20, -54, -3, -13, -2, -15, 16, -10, 11, -9, -16, -7, -13, 25, 37, 17, 13, 4, -3, 8, -1, 25, -5, 2, 5, 2, 31, 38, -15, 16, 23, -40, 7, 8, 13, 6, -5, 11, -4, 6, 18, 2, 13, -11, 11, -7, -16, -7, 9, -20, 10, -8, 8, -20, -5, -15, 14, -1, -21, 5, 16, -12, 15, 2, 9, -11, -4, -21, 6, -5, -4, -16, -4, -13, -12, -7, -16, 17, -21, 8, -20, 3, 15, -16, -4, 7, -6, -20, 3, -16, 20, -2, -9, -22, 19, 4, -14, -13, 4, 16, 7, 18, -8, 17, 22, -5, 9, 21, -1, 29, -19, 19, 3, 0, 7, 9, 36, 8, -17, 7, 6, -49, 5, -14, 2, -8, 2, 27, -22, -7, -10, 10, -5, -64, -78, -20, 10, -2, 25, -14, -15, -17, 6, 11, 7, -49, -72, -22, 0, -20, -4, 24, 4, 1, 15, 19, -18, -32, 41, -41, 1, 15, -1, 14, 30, -1, 4, 17, -20, 29, -20, -1, -1, -4, -7, 42, 50, 36, -14, 17, -3, -42, 4, -14, 13, -22, 20, 31, 20, -2, 1, 17, 16, -18, -16, 12, 0, -17, 21, -17, -17, 15, 12, 6, -4, -15, -10, 23, -15, 11, -18, -4, 15, 17, -7, -1, -7, 13, -8, -7, -7, -21, -22, 29, 29, 12, 21, 8, -5, 31, 19, 19, -14, 19, 0, 3, 32, 16, -20, 1, 23, -38, -18, -12, -3, 19, 22, 12, 20, -8, -1, -5, 4, -1, 10, 13, 14, -14, 11, -25, 15, 0, 13, 16, 13, -11, 1, 3, 20, 14, 1, 4, 21, 1, -9, 18, -21, -13, 4, -20, -20, 16, 2, 20, -14, 13, -6, -1, -7, -18, -18, -13, 18, -9, -13, -3, 12, -13, -8, 15, 16, 13, -21, 9, 14, -9, -18, 7, -2, -17, 18, -20, 3, 9, 21, 1, 9, 26, -14, -2, -3, 31, -13, 7, -20, 27, 45, 17, -2, 21, 2, -21, -13, 2, -9, -1, 24, 6, 10, 15, 8, 4, 1, 8, 20, -6, -15, 21, -15, 30, -20, 16, -4, -20, -8, 35, 30, 0, -2, -10, 27, -35, -14, -12, 21, 8, -9, 18, 8, 15, 9, -8, 5, 34, 51, -9, 11, 4, -16, 35, 8, -3, 18, 9, 0, 34, 9, 23, 7, -17, -12, -40, 10, 7, -8, 15, 19, 16, -17, 5, 10, 14, 5, 4, 37, 5, 20, 27, -34, 30, 6, 30, -11, 18, 18, 14, 36, 16, -19, 12, -6, -45, -4, 0, -3, -13, 32, 22, -14, 30, 19, -17, -8, 24, 9, 10, -15, 9, -28, 20, -8, 8, 8, -1, 7, 32, 44, 31, -9, -2, -6, -15, -5, 17, 14, 3, -2, 20, -15, 29, -6, -6, 20, 22, 30, 17, 16, 13, -17, 0, 22, 30, 14, -13, 17, 23, 9, 23, 4, -4, 13, -40, 12, 16, 20, -14, 29, 26, -1, 28, -6, -7, 3, -15, -10, 17, 9, 19, 12, 5, 2, 11, 21, -21, -5, 8, 14, -17, -7, -13, -14, -16, -16, -11, -14, -20, -18, 1, -12, 9, -10, 18, 10, 24, 19, -15, 3, 8, 1, 5, 8, 18, 4, -11, -14, 15, 26, 20, -15, -2, 28, -44, -15, -7, 10, -12, 25, -9, 0, 16, 17, 18, 3, 16, 33, 1, 8, -4, -24, 19, 14, 16, -5, -2, 10, 11, 15, 15, 18, 0, 23, -18, -11, 13, -8, 15, 13, 19, 16, -1, 19, 11, 14, -1, -17, 8, -7, -19, -16, 8, 10, 2, -4, 2, 9, -5, -6, 14, 21, -15, -9, -2, 12, -14, -7, -19, -11, 4, 3, -20, 3, 11, -7, 33, 22, 15, 16, 26, -27, 36, 8, 19, -16, 3, -19, 32, 10, 35, 21, -6, 25, -43, 16, -5, 8, 17, 16, -3, 18, 34, -17, -18, 0, 3, 42, 1, -10, 19, -17, 25, -7, 34, 17, 11, -1, 43, 4, 14, -18, -9, 5, -29, -11, 18, 3, -22, 20, 6, 9, 11, 24, -16, -19, -22, 0, -5, -20, 8, 11, 8, -19, -24, 1, 19, 21, 13, 6, -11, -10, -20, 17, -20, -16, -2, 13, -3, -8, 12, 5, 13, -12, 7, 7, 10, 25, 6, -8, 29, -2, 32, -20, 9, 4, -18, -18, 22, 7, 11, -8, -12, 15, -50, -3, 2, -7, 13, -1, 23, 20, 8, -15, 22, 15, 9, -2, 2, -4, -15, 0, 14, -11, -20, 6, 8, 2, -10, -2, -15, -8, -18, 21, -19, 16, 7, 15, 6, 6, -14, -3, -13, 2, -2, -36, -74, -124, -1, 3, -14, 56, -4, -4, -27, 2, 2, 4, -62, -127, -49, -2, -6, -21, 30, -5, -4, -9, -20, -13, -35, 28, -64, -56, -14, -19, -18, -12, -21, 1, -14, -10, -10, 2, -18, -6, -21, 7, 1, -10, 8, 16, -4, -14, 0, 0, 8, -11, 3, 12, -9, 21, 19, -14 };
+static const int32_t solar_power_prediction_q8_layer_3_biases[30] = { 13870, 10658, 10483, -3067, 10809, 7505, -1757, -3426, 9074, 8675, 52782, 10188, -7716, 54060, -2847, -2289, 7142, 51723, -3864, 9384, 11804, -1246, -1588, -1659, 4793, 0, 6917, 54684, 47963, 51505 };
+static const int8_t solar_power_prediction_q8_layer_3_weights[900] = { 7, 58, 20, -19, -14, 9, 23, 71, 0, 0, -4, -16, 8, -14, -23, -8, -14, -8, 0, 14, 10, 6, -4, -6, 4, 24, 12, 10, 101, -18, 18, -58, 10, 42, -18, -4, 29, -30, 33, 20, 38, 14, 19, 30, 46, 15, 4, 27, 46, -13, 45, -9, 16, 39, 14, 20, 11, 18, -86, 13, 0, -58, 30, 44, 13, -13, 45, -25, 51, 9, 28, -1, -1, 7, 22, 31, 43, -1, 36, -25, -1, 41, -2, 12, 36, 17, 33, 4, -106, 12, -14, -4, 7, 17, 6, -11, 24, -12, -25, 22, -13, 6, -3, -29, -27, 23, -15, 26, -10, 13, 4, -11, -16, -26, -13, 7, 1, 6, -4, 19, -4, -78, 44, 10, -10, -11, 9, -27, 39, -27, 14, -25, 11, 41, 7, 25, 46, 33, -1, -7, 44, 10, -4, 32, 28, -15, -4, 27, -88, -15, -14, -49, 8, 17, -1, 16, -3, -31, 26, -22, 30, 25, 16, 24, 44, 7, 45, -1, 2, -24, 8, -3, 1, 40, 18, -5, 40, 24, -73, 1, 7, -25, -20, 13, 0, -7, -28, 15, -8, 19, 4, 7, -7, -18, 7, 5, 14, -3, 7, -8, -10, -17, 17, -1, -2, -5, -19, 26, -13, 21, -13, -16, -15, 13, -1, -17, -34, -4, 5, 16, -14, 5, 24, -21, 12, -2, -34, -20, -30, 11, -9, -13, -37, -13, -11, -7, 17, -17, 3, -12, -5, -100, -4, 39, 14, 7, 42, -15, 45, 12, 21, 17, -23, 16, 9, 45, 36, 14, 36, 0, -3, 43, -13, 16, 43, 22, 1, -17, -77, -15, 11, -64, 13, 36, 14, -18, 17, -42, 32, 24, 25, -18, -16, 27, 22, 7, 49, 47, 42, 23, 32, 1, 12, 4, 42, -8, 45, -20, -112, -6, -1, 16, -56, -42, -16, -3, -50, -13, -34, 1, 24, -9, -17, 18, -13, -92, -13, -87, -54, 3, -41, 23, -9, -49, 24, 20, -26, 22, 24, 19, 26, -50, -3, 14, -16, -20, 41, -10, 23, 20, -8, -9, -12, 4, 44, 9, 33, 39, 10, 8, 26, 5, 6, 41, 28, -13, 34, -3, -76, 18, -9, -1, 26, -9, 9, 17, 19, -8, -33, -24, -56, 20, 20, -66, -30, -18, 2, -31, -28, -14, 11, -61, 10, -11, -49, -11, -8, 20, 5, -19, 2, 35, -32, -80, 16, 25, -45, 5, -60, -14, 9, -8, -21, 26, -23, -96, -26, -72, -90, -21, -49, 13, -19, -54, 33, 23, -17, -7, 1, -15, 10, -1, 3, -28, 9, 15, -7, 3, -10, -20, -17, -22, 22, -12, -20, -30, -27, 17, 18, 17, -19, 8, -21, -2, -16, -6, 5, 19, -14, 21, -11, -35, -4, -22, -15, 18, 13, -31, 2, 3, -20, -18, -7, -7, 17, 15, -16, -12, -5, 21, -18, -11, 2, -20, 9, 0, -12, 21, 17, 9, -28, 49, -18, -36, -8, -7, -16, -9, -17, 67, 28, -15, 9, 28, -33, -22, -27, -17, -14, 4, -29, -27, 22, -5, 31, 10, -25, 6, 47, 3, 3, 20, -30, -96, -12, 23, -32, -32, -109, 14, 18, 18, -10, 27, -32, -116, -40, -112, -46, -10, -33, 24, 11, -44, 20, -17, -9, -25, 35, -1, -26, -18, -23, -7, 20, 19, -20, -3, 9, -11, -21, -6, -5, -6, 1, 5, -4, -8, 21, 15, 0, -10, -20, 9, -13, -21, -13, -19, 13, -4, 2, -93, 45, 32, -25, 9, 58, -46, 57, -11, 41, -22, -17, 34, 14, 44, 8, 20, 25, 22, 43, 45, -3, 19, 28, 28, 4, 17, -113, 12, -4, -82, 51, 17, 21, -20, 44, -24, 26, 16, 7, -25, -8, 51, 45, 41, 53, 30, 42, -25, 40, 47, -5, 53, -1, -17, 48, 25, -115, -19, 5, -16, 19, -28, 9, -23, 15, -4, 21, -20, -30, 11, -10, -22, 20, -21, 11, -15, 8, -18, 17, -26, -25, -8, -17, 0, 19, 6, -11, 9, -29, -9, -31, -11, -13, 23, 11, -22, -20, 23, -31, -16, 20, -1, -3, -9, 12, 3, -21, 4, -24, 21, 16, 8, 1, 26, 2, -25, -19, -22, -23, -6, 15, 21, -19, 15, 10, -2, -7, -18, -24, -23, -18, -31, -19, 18, -32, 19, -6, 18, -17, -28, 0, 19, 14, -2, 21, -15, -29, 8, -8, -88, 28, 5, -20, -16, 11, -33, 1, 18, 38, 1, 5, 20, 15, 33, 0, 36, 41, 24, 11, 27, 8, 27, 30, 22, 30, 16, -87, 23, 5, -27, -16, -11, -11, -7, -13, -26, 5, 22, -17, -10, 5, 4, 25, -1, -24, -13, -11, -12, 26, 5, 20, -6, -21, 23, -24, 24, 12, 15, 6, -83, 30, 39, 14, 20, 23, -3, -1, -28, 40, -6, -1, -3, 29, 12, 36, 17, 26, -16, 29, 1, -6, 41, 27, -1, 33, 12, -109, -19, -4, 33, -49, -94, 0, -11, -48, 2, -113, 1, 30, -8, 10, 37, 15, -101, -7, -102, -77, 1, -57, -14, -22, -75, 14, 20, -31, 10, -9, -23, -4, 18, -25, -61, 18, -4, -32, -31, -63, -12, 5, 9, 0, 35, 6, -127, 2, -103, -78, 3, -32, -4, 4, -39, 19, 9, -51, 21, 21, 7, -16, 16, -66, -64, 11, 5, -69, -10, -43, 6, 30, 4, -2, 16, 17, -63, 3, -67, -55, 18, -55, -9, 18, -58, 31, 21, -13, -18, 24, -15 };
+static const int32_t solar_power_prediction_q8_layer_4_biases[1] = { 213731 };
+static const int8_t solar_power_prediction_q8_layer_4_weights[30] = { -47, 61, 58, 40, 71, 84, -37, 31, 66, 61, -103, 85, 39, -113, 15, -20, -71, -95, -15, 52, 44, -47, -1, -19, 74, 43, 66, -127, -123, -102 };
+static int16_t solar_power_prediction_q8_buf1[30];
+static int16_t solar_power_prediction_q8_buf2[30];
+static int16_t solar_power_prediction_q8_batch1[Q8_NET_BATCH * 30];
+static int16_t solar_power_prediction_q8_batch2[Q8_NET_BATCH * 30];
+static const Q8NetLayer solar_power_prediction_q8_layers[5] = { 
+{ 21, 3, solar_power_prediction_q8_layer_0_weights, solar_power_prediction_q8_layer_0_biases, 1058275977, 37, Q8NetActivationRelu }, 
+{ 30, 21, solar_power_prediction_q8_layer_1_weights, solar_power_prediction_q8_layer_1_biases, 1006681045, 37, Q8NetActivationRelu }, 
+{ 30, 30, solar_power_prediction_q8_layer_2_weights, solar_power_prediction_q8_layer_2_biases, 664257130, 37, Q8NetActivationRelu }, 
+{ 30, 30, solar_power_prediction_q8_layer_3_weights, solar_power_prediction_q8_layer_3_biases, 613774836, 38, Q8NetActivationRelu }, 
+{ 1, 30, solar_power_prediction_q8_layer_4_weights, solar_power_prediction_q8_layer_4_biases, 0, 0, Q8NetActivationIdentity } };
+static const float solar_power_prediction_q8_input_scales[3] = { 6.553400000e+02f, 3.744800000e+02f, 1.638350000e+04f };
+static const Q8Net solar_power_prediction_q8 = { 5, solar_power_prediction_q8_layers, solar_power_prediction_q8_buf1, solar_power_prediction_q8_buf2, 30, solar_power_prediction_q8_input_scales, 1.368585591e-04f };
+
+    float
+    solar_power_prediction_q8_regress1(const float *features, int32_t n_features)
+    {
+        return q8_net_regress1(&solar_power_prediction_q8, features, n_features);
+    }
+
+    int32_t
+    solar_power_prediction_q8_regress(const float *features, int32_t n_features, int32_t n_samples, float *outputs)
+    {
+        return q8_net_regress(&solar_power_prediction_q8, features, n_features, n_samples, solar_power_prediction_q8_batch1, solar_power_prediction_q8_batch2, outputs);
+    }
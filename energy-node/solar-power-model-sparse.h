@@ -0,0 +1,28 @@
+// Generated by ML-expected-solar-power/prune_model.py, do not edit.
+// Dead neurons removed per layer: 9, 0, 0, 0
+#include "sparse-net.h"
+static const float solar_power_prediction_sparse_layer_0_biases[21] = { 0.627853f, 0.038723f, -0.000208f, -0.264222f, -0.280703f, 0.000000f, 0.000000f, 0.000000f, 0.000000f, 0.032631f, -0.018204f, -0.031927f, 0.000000f, 0.086800f, 0.000000f, 0.000000f, -0.080608f, 0.034972f, 0.000000f, -0.362918f, 0.000000f };
+static const float solar_power_prediction_sparse_layer_0_weights[63] = { 0.472116f, -0.267641f, -4.597878f, 0.137295f, 0.237745f, 4.165892f, -0.105440f, 0.103567f, 3.504244f, 0.111488f, 0.137707f, -4.021473f, 0.128492f, 0.031306f, -3.597260f, -0.182050f, -0.326495f, 0.351530f, -0.096071f, -0.218805f, 0.409147f, 0.132481f, -0.264009f, -0.381438f, -0.423894f, -0.123745f, 0.006895f, 0.361679f, -0.204920f, 3.091240f, -0.074849f, 0.080100f, 4.160522f, 0.372119f, -0.441316f, -0.266386f, 0.069043f, -0.305979f, 0.325613f, 0.366832f, 0.015608f, 3.408001f, -0.254324f, 0.090783f, -0.020253f, 0.242190f, -0.301765f, 0.250569f, 0.194313f, 0.257478f, 3.671882f, 0.387392f, -0.108014f, -4.342698f, 0.008730f, -0.183283f, -0.378637f, 0.131613f, 0.085505f, -3.606057f, -0.182166f, 0.001346f, 0.418726f };
+static const float solar_power_prediction_sparse_layer_1_biases[30] = { 0.000000f, 0.322031f, 0.119935f, 0.344765f, -0.015428f, -0.047882f, 0.194593f, 1.009418f, 0.189364f, -0.028852f, 0.183769f, -0.059664f, -0.031729f, 0.000000f, 0.130097f, 0.084495f, 0.091119f, 0.000000f, 0.000000f, 0.177278f, 0.132096f, 0.000000f, 0.000000f, 0.000000f, -0.024680f, 0.187120f, 0.276410f, 0.222917f, 0.330484f, 0.329627f };
+static const float solar_power_prediction_sparse_layer_1_weights[630] = { 0.215356f, -0.302955f, 0.240128f, 0.270288f, -0.292113f, 0.295544f, 0.253425f, 0.201503f, 0.186446f, -0.177322f, -0.088310f, 0.305085f, -0.178205f, -0.028444f, 0.068071f, -0.253329f, -0.306834f, -0.040493f, -0.225800f, -0.012939f, -0.067889f, 0.009655f, -0.002425f, 0.252113f, -0.458865f, -0.442531f, 0.004422f, -0.195258f, -0.094144f, -0.250164f, 0.397108f, 0.068224f, 0.109335f, -0.101805f, 0.157161f, 0.018320f, 0.021750f, -0.153545f, -0.416934f, 0.153505f, -0.019766f, 0.162691f, -0.456599f, 0.294246f, 0.172387f, -0.110783f, -0.018711f, 0.021075f, 0.161853f, -0.039928f, -0.072724f, 0.230927f, 0.540065f, 0.217827f, -0.105238f, 0.228261f, 0.212917f, 0.104817f, 0.350653f, -0.578865f, -0.099922f, -0.220052f, 0.302695f, -0.138964f, 0.057936f, 0.043865f, -0.381696f, -0.670258f, -0.137120f, -0.240363f, 0.176276f, 0.253500f, 0.682694f, 0.596207f, -0.226847f, -0.309906f, 0.434616f, -0.077481f, 0.116073f, -0.041548f, -0.127583f, -0.065280f, -0.398004f, 0.272182f, -0.270633f, -0.081414f, -0.159983f, -0.049114f, -0.171113f, 0.003708f, -0.211274f, -0.127967f, -0.077498f, -0.165426f, -0.087822f, 0.264256f, 0.260897f, 0.263331f, 0.106906f, 0.132282f, -0.017602f, 0.108273f, 0.221684f, -0.115409f, -0.313303f, 0.233764f, -0.164287f, -0.043785f, 0.158048f, -0.250412f, 0.242850f, 0.287471f, -0.230566f, -0.017579f, -0.086456f, 0.091826f, 0.226046f, 0.213305f, -0.104286f, 0.067090f, -0.165337f, -0.057383f, -0.080057f, 0.291542f, 0.120074f, 0.063663f, -0.107922f, 0.430934f, 0.261023f, -0.408407f, -0.293864f, 0.165670f, 0.134872f, -0.272705f, -0.015498f, 0.817016f, 0.023510f, -0.202478f, 0.226592f, 0.080228f, -0.088034f, 0.007047f, 0.019803f, -0.494142f, 0.017740f, 0.129420f, -0.156993f, 0.872410f, -0.038489f, -0.903774f, -0.040495f, 0.531371f, 0.215796f, 0.019941f, -0.275990f, -0.232954f, 0.285034f, -0.920594f, -0.079076f, 0.189173f, -0.165616f, -0.193893f, 0.293663f, -0.376815f, 0.622967f, -0.038300f, 0.044148f, 0.267547f, -0.222599f, 0.440721f, -0.155752f, -0.550984f, -0.159415f, 0.191886f, 0.057225f, -0.099479f, 0.099914f, 0.786290f, 0.215596f, -0.088834f, -0.094625f, 0.431401f, 0.279219f, 0.101972f, 0.301817f, -0.256184f, -0.100499f, -0.347866f, -0.185157f, -0.075952f, -0.008254f, -0.304433f, -0.065957f, -0.248309f, 0.027936f, 0.294664f, 0.182134f, -0.169303f, -0.085230f, -0.217573f, -0.071087f, 0.073145f, -0.023279f, -0.179388f, 0.070951f, 0.166029f, 0.260650f, 0.197112f, -0.312687f, -0.241941f, -0.424416f, 0.317483f, 0.037392f, -0.403623f, -0.146051f, 0.105763f, 0.020847f, 0.185816f, 0.137209f, 0.762655f, 0.093051f, 0.264841f, -0.196437f, 0.297282f, 0.226755f, -0.288750f, 0.282829f, -0.314857f, -0.128580f, 0.020789f, 0.222589f, -0.011914f, -0.106970f, -0.308115f, 0.101098f, 0.143203f, -0.004060f, 0.131543f, -0.153951f, 0.274094f, -0.357638f, 0.083008f, 0.135945f, 0.195378f, -0.124614f, -0.195265f, 0.096285f, 0.091054f, -0.115380f, 0.137531f, 0.015467f, -0.182462f, 0.181593f, -0.027824f, -0.283413f, -0.316433f, 0.108829f, 0.099754f, 0.233897f, -0.010961f, -0.182888f, -0.020544f, -0.163760f, -0.256093f, 0.043461f, -0.196028f, 0.310228f, 0.261866f, 0.008776f, 0.044057f, 0.154288f, 0.031784f, -0.296747f, -0.153758f, -0.197058f, 0.006042f, -0.220109f, 0.007951f, -0.242366f, 0.020212f, -0.254824f, 0.096440f, 0.090858f, 0.130765f, -0.024810f, 0.234715f, 0.299186f, 0.169189f, 0.068391f, -0.312018f, -0.307918f, -0.125881f, 0.130115f, -0.145290f, -0.333365f, 0.497561f, 0.493931f, -0.590108f, -0.264746f, 0.261373f, -0.314597f, -0.165233f, -0.105667f, 0.271799f, 0.288760f, 0.080197f, -0.289843f, 0.431782f, -0.067659f, -0.071006f, -0.009406f, -0.054226f, -0.267292f, -0.393182f, 0.300689f, -0.358974f, 0.362409f, -0.088598f, -0.502421f, -0.266405f, -0.159606f, -0.067676f, -0.087582f, -0.153526f, 0.697490f, 0.292546f, 0.155626f, -0.314711f, 0.303100f, 0.294381f, 0.025900f, 0.175570f, -0.547699f, 0.311828f, -0.306118f, 0.193342f, -0.010929f, 0.227248f, 0.144472f, -0.135402f, -0.626681f, -0.014081f, 0.274455f, 0.003685f, 0.127246f, 0.730865f, 0.617963f, 0.018776f, 0.282687f, 0.311537f, -0.260774f, -0.130850f, 0.276789f, -0.607239f, -0.035146f, -0.334781f, 0.001915f, -0.126393f, 0.121948f, 0.263811f, -0.071239f, 0.273515f, 0.306578f, 0.098713f, -0.033838f, 0.174886f, -0.144830f, 0.087952f, 0.016929f, 0.107670f, -0.234200f, -0.270757f, 0.313706f, -0.032675f, -0.054852f, 0.074320f, -0.302995f, 0.180893f, 0.315018f, -0.110475f, -0.159833f, 0.301924f, -0.110367f, -0.122886f, -0.305098f, -0.102342f, 0.230642f, -0.210050f, 0.288613f, -0.099560f, 0.229246f, -0.278758f, -0.301496f, 0.206205f, -0.290145f, -0.294000f, 0.163450f, 0.025218f, -0.174456f, -0.344326f, -0.045714f, 0.204790f, -0.379225f, -0.386065f, 0.272142f, 0.310644f, -0.128174f, -0.080679f, 0.639081f, 0.116574f, -0.136800f, -0.012497f, 0.202562f, 0.178825f, -0.158852f, 0.261408f, -0.243967f, -0.271669f, -0.034757f, 0.160330f, 0.098231f, -0.230062f, 0.065569f, 0.779740f, 0.278959f, -0.016796f, -0.222128f, -0.002828f, -0.238514f, -0.086101f, -0.569713f, 0.050652f, -0.034947f, -0.107063f, -0.128830f, -0.284822f, -0.079732f, 0.629517f, 0.102239f, 0.538693f, 0.024466f, 0.270713f, -0.109704f, -0.113837f, -0.292365f, 0.172812f, 0.218150f, 0.099534f, -0.188750f, -0.159453f, -0.254767f, -0.183358f, -0.027051f, -0.283156f, -0.284474f, 0.239069f, 0.296473f, 0.062790f, 0.274898f, 0.154340f, -0.214740f, 0.129008f, 0.135391f, -0.126430f, -0.099098f, -0.174927f, -0.151756f, -0.269113f, 0.140521f, 0.271411f, -0.284662f, 0.275072f, -0.139061f, -0.062923f, -0.185697f, 0.046953f, 0.124331f, -0.099048f, -0.281930f, -0.057084f, -0.252059f, 0.140489f, 0.267582f, -0.024619f, -0.101419f, 0.111499f, -0.094063f, -0.225935f, -0.039552f, -0.082660f, 0.305507f, 0.178751f, -0.160347f, -0.004012f, 0.229913f, 0.302147f, -0.000181f, 0.132630f, 0.287406f, -0.066221f, -0.112268f, -0.149271f, -0.092174f, -0.166753f, 0.137959f, 0.256976f, -0.151123f, -0.091949f, -0.290206f, -0.193234f, 0.195063f, -0.291952f, -0.309187f, 0.047053f, -0.162720f, -0.003593f, -0.260437f, 0.136381f, 0.235832f, -0.073665f, -0.323895f, 0.092104f, 0.241781f, -0.223787f, -0.258159f, 0.006255f, 0.384355f, 0.274204f, -0.128117f, -0.463658f, -0.005075f, 0.052099f, 0.151297f, -0.194882f, 0.599261f, 0.359280f, 0.124692f, 0.069794f, 0.201665f, 0.086481f, -0.083415f, -0.024404f, -0.457045f, -0.248629f, 0.092477f, -0.075812f, -0.469416f, -0.058698f, -0.107880f, -0.314734f, -0.593550f, -0.041432f, 0.084165f, 0.280490f, 0.261060f, 0.823777f, 0.478227f, 0.155926f, -0.229070f, 0.008418f, 0.200905f, -0.250494f, 0.157421f, -0.153464f, -0.098992f, 0.134200f, 0.094621f, -0.048653f, 0.051463f, -0.266858f, -0.392147f, -0.602945f, -0.307414f, 0.294102f, 0.122646f, -0.088139f, 0.404987f, 0.056669f, -0.173302f, 0.227321f, 0.249335f, -0.296811f, -0.261570f, -0.090302f, -0.013983f, -0.310842f, -0.050554f, -0.087736f, -0.351805f, 0.074484f, -0.046559f, -0.100087f, -0.561810f, -0.315823f, 0.281176f, -0.171035f, 0.282308f, 0.696199f, 0.163809f, 0.028492f, -0.219603f, 0.362470f, -0.193943f, -0.268915f, -0.066842f, -0.379782f, 0.221598f, -0.277017f, 0.110314f, 0.285838f, -0.128755f, 0.016923f, -0.281144f, -0.200585f, -0.280898f, -0.301912f, -0.312964f, -0.256459f, 0.543128f, 0.093257f, -0.119044f, 0.076844f, 0.008269f, -0.156955f, -0.025020f, 0.177738f, -0.564571f, 0.118286f, -0.586851f, -0.141507f };
+static const float solar_power_prediction_sparse_layer_2_biases[30] = { -0.107143f, 1.291678f, 0.262787f, 0.363601f, 0.000000f, 0.000000f, 0.276134f, 0.486587f, 0.367567f, 0.086224f, 0.295988f, -0.049119f, 0.000000f, 0.357121f, 0.309969f, 0.165235f, 0.318018f, 0.092665f, 0.338470f, -0.041853f, 0.315801f, 0.230662f, -0.107762f, 0.280735f, 0.337610f, -0.050856f, 0.355199f, 0.000000f, 1.203863f, 0.000000f };
+static const float solar_power_prediction_sparse_layer_2_weights[900] = { -0.016877f, 0.190743f, 0.106451f, 0.010322f, -0.048973f, 0.241306f, -0.133119f, 0.147278f, -0.461369f, -0.179550f, -0.366378f, -0.349441f, -0.075555f, 0.256649f, -0.174858f, -0.012336f, -0.278533f, -0.285998f, 0.121540f, -0.031146f, 0.465792f, 0.190819f, 0.216005f, -0.132146f, 0.117882f, 0.139731f, -0.240822f, 0.323169f, 0.036519f, 0.057606f, 0.139783f, -0.031101f, -0.931821f, -1.449639f, -0.135547f, -0.198090f, 0.069071f, 0.489064f, -0.040171f, -0.294000f, -0.408090f, -0.179278f, 0.233431f, 0.257191f, -0.676221f, -1.164018f, -0.580188f, -0.142748f, -0.214780f, -0.063015f, 0.361054f, 0.214662f, -0.171662f, -0.178441f, 0.149895f, -0.003771f, 0.023917f, 0.499294f, -0.591052f, -0.083252f, -0.217237f, 0.227948f, -0.005808f, 0.696113f, -0.120497f, -0.299495f, 0.212836f, -0.135385f, 0.475593f, -0.125898f, 0.244093f, -0.222555f, -0.183926f, -0.193476f, 0.320194f, 0.186786f, 0.355357f, -0.119726f, 0.187045f, 0.287824f, -0.776332f, -0.045674f, -0.183295f, -0.023898f, -0.210907f, 0.233239f, -0.140108f, 0.161679f, -0.128817f, -0.237453f, -0.100190f, -0.189635f, 0.363011f, 0.530271f, 0.247013f, 0.188709f, 0.053182f, -0.041584f, 0.120845f, -0.018906f, 0.362369f, -0.075552f, 0.034964f, 0.067537f, 0.023244f, 0.446715f, 0.550606f, -0.219486f, 0.226961f, 0.338989f, -0.575508f, 0.102097f, 0.113064f, 0.184728f, 0.081823f, -0.065562f, 0.155275f, -0.059910f, 0.081958f, 0.264232f, 0.023592f, 0.184169f, -0.156818f, 0.157651f, -0.104510f, -0.236312f, -0.098021f, 0.136454f, -0.288151f, 0.142976f, -0.122571f, 0.114902f, -0.294846f, -0.068435f, -0.219285f, 0.196508f, -0.011387f, -0.310224f, 0.071428f, 0.223931f, -0.174497f, 0.221100f, 0.033752f, 0.132928f, -0.160193f, -0.053846f, -0.305368f, 0.080799f, -0.073920f, -0.061693f, -0.228716f, -0.062954f, -0.180736f, -0.175932f, -0.098931f, -0.231580f, 0.244703f, -0.296563f, 0.119494f, -0.295689f, 0.046139f, 0.216895f, -0.234436f, -0.058081f, 0.104695f, -0.091680f, -0.293803f, 0.049544f, -0.225886f, 0.295370f, -0.032965f, -0.125757f, -0.314494f, 0.272507f, 0.059582f, -0.206078f, -0.188962f, 0.059977f, 0.224956f, 0.100457f, 0.256169f, -0.114768f, 0.239514f, 0.314072f, -0.073007f, 0.131817f, 0.306014f, -0.012031f, 0.411476f, -0.269004f, 0.277463f, 0.044176f, -0.003360f, 0.095783f, 0.131961f, 0.514903f, 0.110764f, -0.242395f, 0.103538f, 0.088029f, -0.704625f, 0.070473f, -0.200990f, 0.034899f, -0.109053f, 0.023402f, 0.389958f, -0.324238f, -0.096229f, -0.141741f, 0.148550f, -0.072385f, -0.919612f, -1.123680f, -0.291521f, 0.150318f, -0.031201f, 0.363039f, -0.206825f, -0.219547f, -0.241638f, 0.084008f, 0.163735f, 0.097905f, -0.713298f, -1.038042f, -0.313312f, 0.000735f, -0.295357f, -0.056646f, 0.339864f, 0.063364f, 0.019978f, 0.215631f, 0.268998f, -0.259716f, -0.458216f, 0.591893f, -0.585726f, 0.015229f, 0.212749f, -0.015261f, 0.196904f, 0.435152f, -0.013356f, 0.060462f, 0.249374f, -0.287362f, 0.413223f, -0.292756f, -0.014507f, -0.013912f, -0.053790f, -0.106311f, 0.607931f, 0.716847f, 0.518414f, -0.196612f, 0.249676f, -0.036180f, -0.600597f, 0.051068f, -0.198342f, 0.194633f, -0.314654f, 0.284830f, 0.454059f, 0.295577f, -0.027038f, 0.018030f, 0.239384f, 0.231199f, -0.261381f, -0.236642f, 0.178526f, 0.007179f, -0.243305f, 0.306803f, -0.244641f, -0.240278f, 0.223640f, 0.171128f, 0.090892f, -0.052406f, -0.213007f, -0.137742f, 0.334140f, -0.212095f, 0.155880f, -0.261277f, -0.051257f, 0.217881f, 0.241011f, -0.103943f, -0.009781f, -0.102419f, 0.187885f, -0.117821f, -0.094223f, -0.105572f, -0.305537f, -0.311493f, 0.424201f, 0.414590f, 0.178672f, 0.307140f, 0.120939f, -0.066494f, 0.441440f, 0.274124f, 0.279065f, -0.197775f, 0.267405f, 0.005339f, 0.049627f, 0.455716f, 0.227336f, -0.287659f, 0.014616f, 0.332654f, -0.555239f, -0.259114f, -0.179874f, -0.039026f, 0.281020f, 0.320414f, 0.175391f, 0.286291f, -0.109238f, -0.010074f, -0.067487f, 0.062216f, -0.020872f, 0.150989f, 0.192616f, 0.208146f, -0.199190f, 0.156982f, -0.360327f, 0.214721f, -0.000005f, 0.184438f, 0.224456f, 0.193545f, -0.158134f, 0.015525f, 0.041700f, 0.290637f, 0.196638f, 0.011815f, 0.058053f, 0.299473f, 0.013351f, -0.129292f, 0.260337f, -0.298457f, -0.184222f, 0.060848f, -0.287634f, -0.283021f, 0.234600f, 0.025490f, 0.289757f, -0.195561f, 0.185754f, -0.089710f, -0.018309f, -0.106929f, -0.260923f, -0.261970f, -0.184726f, 0.259376f, -0.129230f, -0.182931f, -0.047719f, 0.166807f, -0.193668f, -0.110862f, 0.212526f, 0.223693f, 0.187823f, -0.296149f, 0.129648f, 0.207340f, -0.126637f, -0.263807f, 0.094525f, -0.024241f, -0.250176f, 0.254937f, -0.294795f, 0.047260f, 0.134724f, 0.302869f, 0.012366f, 0.128799f, 0.373429f, -0.201830f, -0.022300f, -0.049643f, 0.442351f, -0.181287f, 0.106641f, -0.283982f, 0.382711f, 0.649999f, 0.239184f, -0.028948f, 0.304057f, 0.031069f, -0.305562f, -0.189939f, 0.026505f, -0.127607f, -0.015952f, 0.348363f, 0.080419f, 0.139514f, 0.223584f, 0.112150f, 0.053211f, 0.018981f, 0.119636f, 0.289771f, -0.089755f, -0.217434f, 0.307737f, -0.218128f, 0.438122f, -0.284577f, 0.227485f, -0.062220f, -0.283878f, -0.119228f, 0.503017f, 0.437040f, -0.007102f, -0.024099f, -0.148281f, 0.385351f, -0.499627f, -0.199000f, -0.177147f, 0.304543f, 0.108763f, -0.136637f, 0.256726f, 0.112847f, 0.217773f, 0.127873f, -0.114905f, 0.067836f, 0.486361f, 0.735681f, -0.127461f, 0.154377f, 0.063923f, -0.224324f, 0.510493f, 0.114882f, -0.038098f, 0.256531f, 0.137035f, 0.005273f, 0.489714f, 0.137093f, 0.326660f, 0.105726f, -0.243307f, -0.169336f, -0.581813f, 0.143569f, 0.105819f, -0.116590f, 0.218418f, 0.274548f, 0.237412f, -0.238884f, 0.074405f, 0.145471f, 0.198439f, 0.070507f, 0.064545f, 0.540732f, 0.071651f, 0.284931f, 0.384038f, -0.488191f, 0.428492f, 0.084462f, 0.436495f, -0.164488f, 0.255724f, 0.255902f, 0.208345f, 0.513551f, 0.232425f, -0.273902f, 0.178239f, -0.086573f, -0.651401f, -0.064148f, -0.000527f, -0.038954f, -0.190650f, 0.460641f, 0.324150f, -0.207592f, 0.426375f, 0.268474f, -0.240813f, -0.113106f, 0.347063f, 0.135914f, 0.142001f, -0.215652f, 0.126449f, -0.407172f, 0.284226f, -0.110901f, 0.118503f, 0.122134f, -0.020978f, 0.102970f, 0.455383f, 0.636307f, 0.440772f, -0.127961f, -0.024992f, -0.089544f, -0.217607f, -0.074604f, 0.241615f, 0.205454f, 0.039206f, -0.030573f, 0.282811f, -0.214806f, 0.418218f, -0.082320f, -0.087455f, 0.282013f, 0.321184f, 0.438994f, 0.249439f, 0.229671f, 0.193588f, -0.238282f, 0.004332f, 0.315992f, 0.428343f, 0.202952f, -0.188320f, 0.242592f, 0.335026f, 0.126132f, 0.334003f, 0.051467f, -0.058290f, 0.189774f, -0.580525f, 0.179573f, 0.235784f, 0.282515f, -0.200836f, 0.417632f, 0.379498f, -0.011141f, 0.399273f, -0.089798f, -0.097618f, 0.040632f, -0.221976f, -0.141613f, 0.251468f, 0.132393f, 0.267033f, 0.177131f, 0.067141f, 0.031159f, 0.152389f, 0.296370f, -0.304122f, -0.065116f, 0.117655f, 0.196715f, -0.248417f, -0.106647f, -0.187505f, -0.205085f, -0.227682f, -0.225602f, -0.152471f, -0.196176f, -0.293907f, -0.264967f, 0.018724f, -0.166248f, 0.129414f, -0.150043f, 0.265471f, 0.144358f, 0.351506f, 0.274749f, -0.213635f, 0.043239f, 0.108785f, 0.010566f, 0.072826f, 0.117527f, 0.254693f, 0.060089f, -0.157485f, -0.202054f, 0.222518f, 0.368095f, 0.283914f, -0.218692f, -0.024549f, 0.406437f, -0.629045f, -0.216215f, -0.101383f, 0.148909f, -0.177474f, 0.360911f, -0.125885f, 0.002990f, 0.232146f, 0.242965f, 0.258096f, 0.050462f, 0.230349f, 0.473880f, 0.008902f, 0.108992f, -0.053642f, -0.344504f, 0.277512f, 0.200368f, 0.226225f, -0.070149f, -0.023228f, 0.139142f, 0.158022f, 0.209875f, 0.223626f, 0.256426f, -0.003499f, 0.330487f, -0.263359f, -0.158147f, 0.194794f, -0.120923f, 0.221263f, 0.183980f, 0.281313f, 0.231820f, -0.014052f, 0.270200f, 0.161517f, 0.197091f, -0.014484f, -0.248899f, 0.108376f, -0.104051f, -0.268088f, -0.236652f, 0.116609f, 0.148059f, 0.027984f, -0.061127f, 0.034914f, 0.124585f, -0.076990f, -0.089708f, 0.202243f, 0.308151f, -0.212598f, -0.129245f, -0.022242f, 0.174882f, -0.203435f, -0.096255f, -0.277376f, -0.151547f, 0.062536f, 0.038912f, -0.281466f, 0.047330f, 0.161141f, -0.098409f, 0.470405f, 0.318005f, 0.221648f, 0.225916f, 0.373446f, -0.394010f, 0.514017f, 0.115358f, 0.279582f, -0.228646f, 0.038997f, -0.279301f, 0.464959f, 0.148326f, 0.505854f, 0.307673f, -0.089886f, 0.363236f, -0.625924f, 0.231794f, -0.065740f, 0.109732f, 0.240630f, 0.231332f, -0.045527f, 0.256498f, 0.496169f, -0.241401f, -0.266852f, -0.006673f, 0.047514f, 0.602233f, 0.014443f, -0.141984f, 0.267695f, -0.250249f, 0.363459f, -0.105856f, 0.490882f, 0.250630f, 0.152169f, -0.009340f, 0.613706f, 0.062672f, 0.198865f, -0.264650f, -0.126319f, 0.065398f, -0.420441f, -0.159246f, 0.254929f, 0.049587f, -0.317922f, 0.292371f, 0.086693f, 0.125809f, 0.163698f, 0.343813f, -0.235438f, -0.269275f, -0.311654f, 0.005170f, -0.071115f, -0.293051f, 0.118204f, 0.155327f, 0.120353f, -0.267965f, -0.339781f, 0.016358f, 0.279993f, 0.308855f, 0.191072f, 0.080594f, -0.163573f, -0.139866f, -0.285797f, 0.240114f, -0.295806f, -0.233194f, -0.028397f, 0.190512f, -0.048498f, -0.108576f, 0.172380f, 0.075736f, 0.180442f, -0.171449f, 0.105627f, 0.096029f, 0.145604f, 0.364771f, 0.085150f, -0.115228f, 0.421687f, -0.035527f, 0.455493f, -0.292296f, 0.135555f, 0.055245f, -0.258949f, -0.255659f, 0.313777f, 0.099031f, 0.153403f, -0.113068f, -0.173083f, 0.214446f, -0.724609f, -0.036967f, 0.025828f, -0.098055f, 0.183134f, -0.015798f, 0.339074f, 0.287183f, 0.111118f, -0.223657f, 0.314899f, 0.220022f, 0.136925f, -0.031535f, 0.034644f, -0.055418f, -0.210044f, -0.003627f, 0.196073f, -0.153724f, -0.291758f, 0.086372f, 0.114831f, 0.031822f, -0.148647f, -0.035395f, -0.217721f, -0.110439f, -0.253626f, 0.296422f, -0.268468f, 0.225620f, 0.094236f, 0.217700f, 0.088552f, 0.086929f, -0.202894f, -0.049335f, -0.186809f, 0.021732f, -0.033277f, -0.515727f, -1.065583f, -1.790740f, -0.018904f, 0.046511f, -0.207296f, 0.804746f, -0.059116f, -0.055298f, -0.392402f, 0.028561f, 0.030495f, 0.057667f, -0.895204f, -1.832791f, -0.710341f, -0.023176f, -0.079530f, -0.307683f, 0.429464f, -0.073326f, -0.057520f, -0.123022f, -0.288764f, -0.181082f, -0.499749f, 0.397472f, -0.929065f, -0.806582f, -0.202485f, -0.280308f, -0.259617f, -0.176213f, -0.304841f, 0.013048f, -0.201255f, -0.143596f, -0.137459f, 0.031395f, -0.253225f, -0.089831f, -0.304788f, 0.095649f, 0.010313f, -0.146929f, 0.111297f, 0.235670f, -0.051743f, -0.196223f, -0.000350f, 0.003962f, 0.116189f, -0.156112f, 0.045460f, 0.179702f, -0.131085f, 0.306634f, 0.275347f, -0.206314f };
+static const float solar_power_prediction_sparse_layer_3_biases[30] = { 0.576596f, 0.443044f, 0.435765f, -0.127480f, 0.449343f, 0.312005f, -0.073030f, -0.142405f, 0.377230f, 0.360624f, 2.194178f, 0.423520f, -0.320751f, 2.247317f, -0.118343f, -0.095175f, 0.296899f, 2.150151f, -0.160640f, 0.390098f, 0.490717f, -0.051802f, -0.066014f, -0.068975f, 0.199233f, 0.000000f, 0.287564f, 2.273259f, 1.993842f, 2.141081f };
+static const float solar_power_prediction_sparse_layer_3_weights[900] = { 0.081453f, 0.673608f, 0.234092f, -0.217070f, -0.167824f, 0.099368f, 0.269359f, 0.832650f, -0.003732f, -0.001994f, -0.047733f, -0.185391f, 0.099041f, -0.162214f, -0.267879f, -0.090956f, -0.162234f, -0.096476f, 0.003186f, 0.158214f, 0.120235f, 0.066512f, -0.041084f, -0.067998f, 0.044221f, 0.284203f, 0.136845f, 0.116436f, 1.181150f, -0.214487f, 0.204365f, -0.675614f, 0.114905f, 0.495551f, -0.207391f, -0.051779f, 0.341638f, -0.351788f, 0.387882f, 0.235599f, 0.447976f, 0.159434f, 0.225144f, 0.351100f, 0.533186f, 0.171768f, 0.046193f, 0.311871f, 0.534195f, -0.149163f, 0.520282f, -0.106424f, 0.183984f, 0.457862f, 0.161049f, 0.234263f, 0.126266f, 0.215692f, -1.002439f, 0.150234f, -0.000646f, -0.675494f, 0.350214f, 0.513692f, 0.151752f, -0.156964f, 0.526513f, -0.287450f, 0.598228f, 0.103912f, 0.324070f, -0.011790f, -0.016872f, 0.086155f, 0.255569f, 0.358791f, 0.507050f, -0.015138f, 0.418716f, -0.294017f, -0.007941f, 0.473973f, -0.018142f, 0.143942f, 0.426006f, 0.200982f, 0.381133f, 0.050576f, -1.233630f, 0.144121f, -0.164447f, -0.043611f, 0.087140f, 0.192975f, 0.068949f, -0.131496f, 0.283674f, -0.138522f, -0.290959f, 0.260044f, -0.150613f, 0.074844f, -0.033908f, -0.337536f, -0.309633f, 0.272382f, -0.172434f, 0.300739f, -0.119885f, 0.150404f, 0.051205f, -0.125592f, -0.185067f, -0.306706f, -0.146969f, 0.086566f, 0.011833f, 0.069012f, -0.044336f, 0.221949f, -0.044556f, -0.913678f, 0.517278f, 0.116391f, -0.112172f, -0.127209f, 0.101729f, -0.320786f, 0.450731f, -0.313055f, 0.158377f, -0.287824f, 0.129922f, 0.478360f, 0.080827f, 0.286580f, 0.537678f, 0.382043f, -0.014715f, -0.081297f, 0.509762f, 0.118671f, -0.042363f, 0.369836f, 0.329857f, -0.174832f, -0.041952f, 0.313577f, -1.028715f, -0.175564f, -0.160277f, -0.569128f, 0.096969f, 0.197623f, -0.007408f, 0.181493f, -0.036572f, -0.367371f, 0.307534f, -0.257513f, 0.349703f, 0.287369f, 0.182253f, 0.284754f, 0.518581f, 0.077533f, 0.530009f, -0.007424f, 0.028126f, -0.278514f, 0.096061f, -0.031086f, 0.014629f, 0.470332f, 0.206369f, -0.056136f, 0.465533f, 0.275951f, -0.848279f, 0.016326f, 0.082176f, -0.290640f, -0.230187f, 0.147593f, 0.002514f, -0.080251f, -0.328824f, 0.179112f, -0.090100f, 0.224775f, 0.044705f, 0.076299f, -0.081623f, -0.210477f, 0.081567f, 0.059570f, 0.158822f, -0.034772f, 0.078657f, -0.089462f, -0.122304f, -0.203841f, 0.197600f, -0.010535f, -0.026783f, -0.052866f, -0.226171f, 0.304628f, -0.151594f, 0.243645f, -0.146613f, -0.182388f, -0.177406f, 0.154627f, -0.007807f, -0.192716f, -0.393459f, -0.045726f, 0.055896f, 0.181722f, -0.162114f, 0.062280f, 0.281144f, -0.250508f, 0.145565f, -0.017617f, -0.396364f, -0.234106f, -0.354106f, 0.131777f, -0.107116f, -0.156605f, -0.428393f, -0.155797f, -0.130623f, -0.085981f, 0.201153f, -0.193404f, 0.034751f, -0.137848f, -0.061675f, -1.167784f, -0.047387f, 0.456888f, 0.168243f, 0.082013f, 0.495900f, -0.169649f, 0.521026f, 0.136730f, 0.242550f, 0.201805f, -0.269913f, 0.181723f, 0.099778f, 0.526782f, 0.422015f, 0.162421f, 0.416758f, 0.000777f, -0.037246f, 0.502173f, -0.153517f, 0.184556f, 0.499030f, 0.260976f, 0.006812f, -0.196527f, -0.902530f, -0.172766f, 0.122670f, -0.752295f, 0.150762f, 0.417772f, 0.160019f, -0.207209f, 0.201668f, -0.490219f, 0.368835f, 0.276388f, 0.287123f, -0.212109f, -0.186332f, 0.314512f, 0.253783f, 0.084853f, 0.573606f, 0.553093f, 0.490990f, 0.272232f, 0.375862f, 0.014944f, 0.140961f, 0.052468f, 0.490814f, -0.097792f, 0.521062f, -0.231517f, -1.311755f, -0.071838f, -0.012286f, 0.187096f, -0.659084f, -0.492657f, -0.185235f, -0.034466f, -0.578685f, -0.150110f, -0.400811f, 0.013239f, 0.276950f, -0.103411f, -0.196702f, 0.208406f, -0.154102f, -1.076791f, -0.152544f, -1.016352f, -0.626087f, 0.033542f, -0.476566f, 0.267356f, -0.109766f, -0.571379f, 0.279635f, 0.230590f, -0.303829f, 0.253818f, 0.275792f, 0.221743f, 0.298000f, -0.587175f, -0.030296f, 0.166169f, -0.192005f, -0.231411f, 0.481814f, -0.119283f, 0.268187f, 0.229153f, -0.092840f, -0.104277f, -0.137571f, 0.043640f, 0.510298f, 0.107216f, 0.386384f, 0.450995f, 0.114838f, 0.090925f, 0.297846f, 0.057816f, 0.067829f, 0.476565f, 0.323356f, -0.152435f, 0.397407f, -0.037256f, -0.886830f, 0.215919f, -0.104633f, -0.007023f, 0.307506f, -0.100174f, 0.107423f, 0.202206f, 0.219544f, -0.091407f, -0.381671f, -0.284166f, -0.655186f, 0.230693f, 0.229024f, -0.767747f, -0.346967f, -0.209511f, 0.024043f, -0.362418f, -0.326831f, -0.159940f, 0.127142f, -0.707911f, 0.114926f, -0.124390f, -0.570282f, -0.130304f, -0.090060f, 0.236555f, 0.063894f, -0.225967f, 0.022241f, 0.405313f, -0.374081f, -0.939226f, 0.191607f, 0.287738f, -0.530488f, 0.053802f, -0.699403f, -0.167827f, 0.099680f, -0.088526f, -0.246746f, 0.304044f, -0.264709f, -1.123836f, -0.300158f, -0.845457f, -1.050859f, -0.239609f, -0.568599f, 0.145985f, -0.221059f, -0.635384f, 0.385071f, 0.272578f, -0.193268f, -0.082973f, 0.007973f, -0.180621f, 0.116908f, -0.011806f, 0.035409f, -0.329488f, 0.109176f, 0.174811f, -0.076491f, 0.030343f, -0.112254f, -0.235539f, -0.193006f, -0.251525f, 0.257597f, -0.139869f, -0.228462f, -0.355267f, -0.315126f, 0.202970f, 0.204626f, 0.192964f, -0.225186f, 0.093340f, -0.248722f, -0.018768f, -0.189827f, -0.073420f, 0.063574f, 0.226965f, -0.163881f, 0.250200f, -0.131857f, -0.408772f, -0.046650f, -0.258382f, -0.178285f, 0.213793f, 0.153836f, -0.362751f, 0.026478f, 0.033322f, -0.238803f, -0.205409f, -0.077661f, -0.082106f, 0.193172f, 0.172647f, -0.190978f, -0.137937f, -0.059272f, 0.248988f, -0.212082f, -0.132108f, 0.025743f, -0.236401f, 0.102300f, -0.005306f, -0.142597f, 0.246757f, 0.202770f, 0.104076f, -0.321856f, 0.575986f, -0.209886f, -0.422085f, -0.088517f, -0.077940f, -0.187064f, -0.106734f, -0.202396f, 0.778482f, 0.321960f, -0.169272f, 0.109663f, 0.326835f, -0.385870f, -0.254800f, -0.310467f, -0.200143f, -0.166278f, 0.042324f, -0.335017f, -0.320233f, 0.253272f, -0.055026f, 0.363166f, 0.112759f, -0.294271f, 0.071919f, 0.553132f, 0.034379f, 0.030306f, 0.228513f, -0.352196f, -1.120397f, -0.139863f, 0.270994f, -0.376665f, -0.369661f, -1.275285f, 0.160985f, 0.211481f, 0.206813f, -0.115988f, 0.312954f, -0.375532f, -1.351009f, -0.462656f, -1.309495f, -0.538939f, -0.114055f, -0.380226f, 0.274333f, 0.129087f, -0.518577f, 0.231623f, -0.204120f, -0.110729f, -0.296933f, 0.412373f, -0.007709f, -0.303601f, -0.213439f, -0.264420f, -0.077728f, 0.229518f, 0.217962f, -0.233738f, -0.035320f, 0.106806f, -0.130873f, -0.245267f, -0.068064f, -0.062168f, -0.065279f, 0.012964f, 0.062779f, -0.045534f, -0.089921f, 0.250202f, 0.180719f, -0.001098f, -0.116444f, -0.237466f, 0.107974f, -0.150909f, -0.240452f, -0.151382f, -0.216571f, 0.157250f, -0.049984f, 0.019303f, -1.082844f, 0.523081f, 0.376811f, -0.296792f, 0.103978f, 0.676666f, -0.532926f, 0.662597f, -0.133422f, 0.483029f, -0.258634f, -0.198763f, 0.402535f, 0.160629f, 0.510510f, 0.091225f, 0.233812f, 0.286090f, 0.256976f, 0.503921f, 0.529111f, -0.032216f, 0.227027f, 0.331649f, 0.321104f, 0.050099f, 0.193319f, -1.323902f, 0.138648f, -0.042559f, -0.962947f, 0.591411f, 0.196441f, 0.240317f, -0.228125f, 0.510356f, -0.282312f, 0.302149f, 0.185689f, 0.080393f, -0.291897f, -0.092174f, 0.595203f, 0.523060f, 0.480272f, 0.621514f, 0.353278f, 0.487203f, -0.292726f, 0.463607f, 0.544001f, -0.061282f, 0.621973f, -0.016292f, -0.199379f, 0.556035f, 0.290177f, -1.341249f, -0.218856f, 0.057473f, -0.188466f, 0.222085f, -0.328821f, 0.110314f, -0.263763f, 0.172708f, -0.042455f, 0.248045f, -0.228404f, -0.353055f, 0.134124f, -0.120155f, -0.253757f, 0.231497f, -0.249070f, 0.129860f, -0.174475f, 0.092767f, -0.206437f, 0.203858f, -0.304691f, -0.290157f, -0.091246f, -0.203272f, -0.002439f, 0.225807f, 0.073087f, -0.132583f, 0.110524f, -0.340206f, -0.106430f, -0.358926f, -0.130263f, -0.150609f, 0.271528f, 0.124018f, -0.257199f, -0.230823f, 0.271650f, -0.363816f, -0.187538f, 0.230220f, -0.008487f, -0.032994f, -0.106586f, 0.141022f, 0.039552f, -0.245437f, 0.041944f, -0.278218f, 0.250628f, 0.183003f, 0.091556f, 0.015043f, 0.297835f, 0.023977f, -0.295518f, -0.227402f, -0.257169f, -0.270618f, -0.073407f, 0.169272f, 0.242189f, -0.224294f, 0.180809f, 0.119542f, -0.026223f, -0.087088f, -0.206036f, -0.277687f, -0.264097f, -0.209616f, -0.362712f, -0.219254f, 0.210928f, -0.367810f, 0.226017f, -0.066536f, 0.208999f, -0.199550f, -0.330516f, 0.002544f, 0.216493f, 0.168720f, -0.022566f, 0.247638f, -0.177990f, -0.337497f, 0.097269f, -0.092346f, -1.027184f, 0.330610f, 0.061874f, -0.230016f, -0.181046f, 0.133050f, -0.389565f, 0.016161f, 0.204924f, 0.442921f, 0.006840f, 0.063769f, 0.237945f, 0.177884f, 0.386331f, -0.003120f, 0.421587f, 0.481410f, 0.282243f, 0.127532f, 0.315384f, 0.096564f, 0.318637f, 0.353405f, 0.262180f, 0.348907f, 0.181804f, -1.015832f, 0.265652f, 0.063774f, -0.312348f, -0.187267f, -0.134147f, -0.127607f, -0.075957f, -0.148608f, -0.298815f, 0.052860f, 0.254656f, -0.195575f, -0.119645f, 0.063863f, 0.042475f, 0.289962f, -0.012734f, -0.284620f, -0.155844f, -0.131276f, -0.143133f, 0.308288f, 0.055868f, 0.238102f, -0.064871f, -0.245188f, 0.266475f, -0.285881f, 0.285294f, 0.141211f, 0.170982f, 0.066005f, -0.972985f, 0.345279f, 0.459542f, 0.157743f, 0.229053f, 0.273365f, -0.032897f, -0.016783f, -0.324876f, 0.469330f, -0.073002f, -0.011032f, -0.032076f, 0.341606f, 0.142667f, 0.424594f, 0.199596f, 0.308865f, -0.191227f, 0.333933f, 0.007378f, -0.069845f, 0.480901f, 0.313553f, -0.016368f, 0.383887f, 0.143495f, -1.270292f, -0.220234f, -0.048124f, 0.383149f, -0.572525f, -1.098611f, 0.000873f, -0.126833f, -0.556358f, 0.025191f, -1.319768f, 0.009156f, 0.348599f, -0.095183f, 0.118819f, 0.435076f, 0.177240f, -1.175671f, -0.085594f, -1.186194f, -0.900032f, 0.016784f, -0.661365f, -0.167604f, -0.258483f, -0.875241f, 0.167388f, 0.233103f, -0.367030f, 0.116134f, -0.108145f, -0.267546f, -0.043618f, 0.205689f, -0.287725f, -0.709080f, 0.213689f, -0.051190f, -0.370610f, -0.360597f, -0.740255f, -0.138804f, 0.056491f, 0.099898f, 0.004723f, 0.406278f, 0.075406f, -1.482510f, 0.020740f, -1.197346f, -0.905667f, 0.029504f, -0.377685f, -0.041703f, 0.046340f, -0.457931f, 0.216831f, 0.109353f, -0.589535f, 0.247545f, 0.244214f, 0.075961f, -0.181907f, 0.183794f, -0.767313f, -0.743473f, 0.125715f, 0.056556f, -0.807388f, -0.119823f, -0.498016f, 0.073271f, 0.355828f, 0.045179f, -0.025697f, 0.186783f, 0.200532f, -0.734316f, 0.036241f, -0.786872f, -0.647677f, 0.210657f, -0.638283f, -0.105892f, 0.204471f, -0.671785f, 0.359271f, 0.247109f, -0.150304f, -0.207852f, 0.276970f, -0.169656f };
+static const float solar_power_prediction_sparse_layer_4_biases[1] = { 29.250982f };
+static const float solar_power_prediction_sparse_layer_4_weights[30] = { -0.347939f, 0.448051f, 0.429108f, 0.295518f, 0.520025f, 0.619083f, -0.275149f, 0.230031f, 0.487949f, 0.449668f, -0.759683f, 0.626785f, 0.287361f, -0.831311f, 0.108020f, -0.144512f, -0.518480f, -0.696093f, -0.111656f, 0.380590f, 0.321058f, -0.348741f, -0.008398f, -0.142754f, 0.543707f, 0.319373f, 0.483350f, -0.933593f, -0.906518f, -0.746310f };
+static float solar_power_prediction_sparse_buf1[30];
+static float solar_power_prediction_sparse_buf2[30];
+static const SparseNetLayer solar_power_prediction_sparse_layers[5] = { 
+{ 21, 3, solar_power_prediction_sparse_layer_0_weights, NULL, NULL, solar_power_prediction_sparse_layer_0_biases, SparseNetActivationRelu }, 
+{ 30, 21, solar_power_prediction_sparse_layer_1_weights, NULL, NULL, solar_power_prediction_sparse_layer_1_biases, SparseNetActivationRelu }, 
+{ 30, 30, solar_power_prediction_sparse_layer_2_weights, NULL, NULL, solar_power_prediction_sparse_layer_2_biases, SparseNetActivationRelu }, 
+{ 30, 30, solar_power_prediction_sparse_layer_3_weights, NULL, NULL, solar_power_prediction_sparse_layer_3_biases, SparseNetActivationRelu }, 
+{ 1, 30, solar_power_prediction_sparse_layer_4_weights, NULL, NULL, solar_power_prediction_sparse_layer_4_biases, SparseNetActivationIdentity } };
+static const SparseNet solar_power_prediction_sparse = { 5, solar_power_prediction_sparse_layers, solar_power_prediction_sparse_buf1, solar_power_prediction_sparse_buf2, 30 };
+
+    float
+    solar_power_prediction_sparse_regress1(const float *features, int32_t n_features)
+    {
+        return sparse_net_regress1(&solar_power_prediction_sparse, features, n_features);
+    }
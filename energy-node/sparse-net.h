@@ -0,0 +1,74 @@
+#ifndef SPARSE_NET_H_
+#define SPARSE_NET_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// Float MLP inference for the pruned solar power model.
+// Each layer is either dense (one contiguous row per neuron) or CSR:
+// only the nonzero weights of a row are stored, with their input column.
+// Models are generated by ML-expected-solar-power/prune_model.py
+
+typedef enum _SparseNetActivationFunction {
+    SparseNetActivationIdentity = 0,
+    SparseNetActivationRelu,
+} SparseNetActivationFunction;
+
+typedef struct _SparseNetLayer {
+    int32_t n_outputs;
+    int32_t n_inputs;
+    const float *weights;     // dense: [n_outputs][n_inputs], CSR: nonzero values row by row
+    const uint16_t *row_ptr;  // CSR: first weight of each row (n_outputs + 1), NULL if dense
+    const uint8_t *col_idx;   // CSR: input column of each weight, NULL if dense
+    const float *biases;
+    SparseNetActivationFunction activation;
+} SparseNetLayer;
+
+typedef struct _SparseNet {
+    int32_t n_layers;
+    const SparseNetLayer *layers;
+    float *activations1;
+    float *activations2;
+    int32_t activations_length;
+} SparseNet;
+
+static void
+sparse_net_layer_forward(const SparseNetLayer *layer, const float *in, float *out)
+{
+    for (int32_t o = 0; o < layer->n_outputs; o++) {
+        float sum = layer->biases[o];
+
+        if (layer->row_ptr == NULL) {
+            const float *row = layer->weights + o * layer->n_inputs;
+            for (int32_t i = 0; i < layer->n_inputs; i++)
+                sum += row[i] * in[i];
+        } else {
+            for (uint16_t k = layer->row_ptr[o]; k < layer->row_ptr[o + 1]; k++)
+                sum += layer->weights[k] * in[layer->col_idx[k]];
+        }
+
+        if (layer->activation == SparseNetActivationRelu && sum < 0.0f)
+            sum = 0.0f;
+        out[o] = sum;
+    }
+}
+
+// Single output regression, NAN on size mismatch
+static float
+sparse_net_regress1(const SparseNet *net, const float *features, int32_t n_features)
+{
+    if (n_features != net->layers[0].n_inputs || net->layers[net->n_layers - 1].n_outputs != 1)
+        return NAN;
+
+    const float *in = features;
+    float *out = net->activations1;
+    for (int32_t l = 0; l < net->n_layers; l++) {
+        sparse_net_layer_forward(&net->layers[l], in, out);
+        in = out;
+        out = (out == net->activations1) ? net->activations2 : net->activations1;
+    }
+    return in[0];
+}
+
+#endif /* SPARSE_NET_H_ */
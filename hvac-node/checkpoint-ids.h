@@ -0,0 +1,8 @@
+#ifndef CHECKPOINT_IDS_H_
+#define CHECKPOINT_IDS_H_
+
+// Ids of the hvac node checkpoint items, see checkpoint.h. The records
+// in the log are matched by id: append new items, never renumber.
+enum checkpoint_id_t { CKPT_SETTINGS, CKPT_ROOMTEMP, CKPT_POWER };
+
+#endif /* CHECKPOINT_IDS_H_ */
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "node-bench.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+
+// Host benchmark of the hvac node hot paths: make bench (TARGET=native)
+
+// external resources
+void update_roomTemp();
+void roomTemp_json_string(char* buffer);
+void settings_json_string(char* buffer);
+void get_value_from_json(const uint8_t *payload, int len);
+void get_value_from_senml(const uint8_t *payload, int len);
+int roomTemp_senml_cbor(uint8_t* buffer);
+int settings_senml_cbor(uint8_t* buffer);
+extern float outTemp;
+extern float gen_power;
+extern float battery_level;
+
+// Notifications as sent by the energy node
+static const char weather_json[] = "{\"n\":\"weather\",\"irr\":0.750,\"outTemp\":27.500,\"modTemp\":40.000}";
+static const char battery_json[] = "{\"n\":\"battery\",\"v\":\"5230.125\"}";
+static const char gen_power_json[] = "{\"n\":\"gen_power\",\"v\":\"1523.871\"}";
+
+// snprintf based str() the nodes used before fixed-fmt.c, for comparison
+static char* snprintf_float(float value, char* output)
+{
+    int integer = (int) value;
+    float fraction = value - integer;
+    fraction = fraction < 0 ? -fraction : fraction; // abs
+    int fraction_int = (int)(fraction * 1000);
+    const char* zeros = fraction_int == 0.0 ? "" : 
+                    fraction_int < 10 ? "00" : 
+                    fraction_int < 100 ? "0" : "";
+    int snlen = snprintf(output, 16, "%d.%s%d", integer, zeros, fraction_int);
+    output[snlen] = '\0'; // Ensure null termination
+    return output;
+}
+
+// Every prefix of a notification may update a field only to its value in
+// the complete one; random corruptions must just not crash (run with
+// -fsanitize=address to check reads past the payload).
+static void fuzz_json(const char *json, int len, float *field, float expected)
+{
+    static uint8_t mutated[COAP_MAX_CHUNK_SIZE];
+
+    for (int cut = 0; cut <= len; cut++) {
+        *field = -1.0f;
+        get_value_from_json((const uint8_t *)json, cut);
+        if ((*field != -1.0f && *field != expected) || (cut == len && *field != expected)) {
+            printf("fuzz: \"%.*s\" gave %f\n", cut, json, *field);
+            exit(1);
+        }
+    }
+
+    for (unsigned long i = 0; i < NODE_BENCH_ITERATIONS; i++) {
+        memcpy(mutated, json, len);
+        for (int k = rand() % 4; k >= 0; k--)
+            mutated[rand() % len] = rand();
+        get_value_from_json(mutated, rand() % (len + 1));
+    }
+    printf("fuzz %-30s ok\n", json);
+}
+
+PROCESS(hvac_node_bench_process, "HVAC Node Benchmark");
+
+PROCESS_THREAD(hvac_node_bench_process, ev, data)
+{
+    static char buffer[COAP_MAX_CHUNK_SIZE];
+    const unsigned long n = NODE_BENCH_ITERATIONS;
+
+    PROCESS_BEGIN();
+
+    node_bench_header("hvac-node");
+
+    NODE_BENCH("update_roomTemp", n, update_roomTemp(), 0);
+
+    NODE_BENCH("snprintf_float", n, snprintf_float(1523.871f, buffer), strlen(buffer));
+    NODE_BENCH("fmt_float", n, fmt_float(1523.871f, buffer), strlen(buffer));
+
+    NODE_BENCH("roomTemp_json_string", n, roomTemp_json_string(buffer), strlen(buffer));
+    NODE_BENCH("settings_json_string", n, settings_json_string(buffer), strlen(buffer));
+
+    static int len;
+    NODE_BENCH("roomTemp_senml_cbor", n, len = roomTemp_senml_cbor((uint8_t *)buffer), len);
+    NODE_BENCH("settings_senml_cbor", n, len = settings_senml_cbor((uint8_t *)buffer), len);
+
+    NODE_BENCH("get_value_from_json weather", n,
+               get_value_from_json((const uint8_t *)weather_json, sizeof(weather_json) - 1), sizeof(weather_json) - 1);
+    NODE_BENCH("get_value_from_json battery", n,
+               get_value_from_json((const uint8_t *)battery_json, sizeof(battery_json) - 1), sizeof(battery_json) - 1);
+    NODE_BENCH("get_value_from_json power", n,
+               get_value_from_json((const uint8_t *)gen_power_json, sizeof(gen_power_json) - 1), sizeof(gen_power_json) - 1);
+
+    fuzz_json(weather_json, sizeof(weather_json) - 1, &outTemp, 27.5f);
+    fuzz_json(battery_json, sizeof(battery_json) - 1, &battery_level, 5230.125f);
+    fuzz_json(gen_power_json, sizeof(gen_power_json) - 1, &gen_power, 1523.871f);
+
+    // same notifications as SenML-CBOR
+    static uint8_t weather_cbor[64], battery_cbor[32];
+    int weather_len = senml_cbor_record(senml_cbor_record(senml_cbor_record(senml_cbor_pack(weather_cbor, 3),
+                          "weather/", "irr", 0.75f), NULL, "outTemp", 27.5f), NULL, "modTemp", 40.0f) - weather_cbor;
+    int battery_len = senml_cbor_record(senml_cbor_pack(battery_cbor, 1), "battery", NULL, 5230.125f) - battery_cbor;
+    NODE_BENCH("get_value_from_senml weather", n, get_value_from_senml(weather_cbor, weather_len), weather_len);
+    NODE_BENCH("get_value_from_senml battery", n, get_value_from_senml(battery_cbor, battery_len), battery_len);
+
+    exit(0);
+
+    PROCESS_END();
+}
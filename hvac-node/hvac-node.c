@@ -7,8 +7,13 @@
 #include "coap-observe-client.h"
 #include "os/dev/button-hal.h"
 #include "os/dev/leds.h"
-#include "jsonparse.h"
+#include "random.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "profile.h"
+#include "node-config.h"
+#include "checkpoint.h"
 
 /* Log configuration */
 #define LOG_MODULE "HVAC"
@@ -31,13 +36,30 @@
 #define LONG_INTERVAL CLOCK_SECOND * 15
 #define SHORT_INTERVAL CLOCK_SECOND * 7
 #define BLINK_INTERVAL CLOCK_SECOND * 0.1
-#define GREEN_INTERVAL CLOCK_SECOND * 10
-#define GREEN_HOURS GREEN_INTERVAL / CLOCK_SECOND / 3600.0 // hours
+#define GREEN_INTERVAL CLOCK_SECOND * 10 // default of the config resource
+#define GREEN_HOURS ((float) green_interval / CLOCK_SECOND / 3600.0) // hours
+
+// Observation watchdog: an observation is lost after OBS_STALE_FACTOR
+// expected intervals without notifications, or a registration after
+// OBS_REGISTER_TIMEOUT without answer, then it is registered again after
+// a jittered backoff doubling from OBS_BACKOFF_MIN to OBS_BACKOFF_MAX
+#define OBS_WATCHDOG_INTERVAL CLOCK_SECOND
+#define OBS_STALE_FACTOR 2
+#define OBS_REGISTER_TIMEOUT (CLOCK_SECOND * 120) // past the CoAP retransmissions
+
+// Heartbeats (pmax) of the energy node notification policies: unchanged
+// values are still notified at least this often. Only until the first
+// notification: then the Max-Age of each one, which follows the policy,
+// the sampling intervals and the energy node status (see notify-policy.h)
+#define OBS_MAX_AGE_LIMIT 86400 // seconds, NOTIFY_MAX_AGE_IDLE
+#define WEATHER_PMAX (CLOCK_SECOND * 60)
+#define BATTERY_PMAX (CLOCK_SECOND * 60)
+#define GEN_POWER_PMAX (CLOCK_SECOND * 30)
+#define OBS_BACKOFF_MIN (CLOCK_SECOND * 2)
+#define OBS_BACKOFF_MAX (CLOCK_SECOND * 64)
 
 // Power parameters
 #define VENT_POWER 50.0
-#define DELTAT_COEFF 0.02
-#define POWER_COEFF 0.0004
 #define SECONDS 7.0
 #define DC_AC_COEFF 10.0
 
@@ -53,6 +75,13 @@ extern float conditioner_power;
 extern enum status_t status;
 extern enum cond_mode_t cond_mode;
 extern float target_temp;
+extern float deltat_coeff, power_coeff; // room model, see res-roomTemp.c
+extern const config_t node_config;
+
+// State kept across reboots, see checkpoint.h
+extern checkpoint_item_t settings_checkpoint, roomTemp_checkpoint, power_checkpoint;
+static checkpoint_item_t *const checkpoints[] = { &settings_checkpoint, &roomTemp_checkpoint, &power_checkpoint, NULL };
+clock_time_t roomTemp_sample_interval();
 
 // data from energy node
 float outTemp = 27.5;
@@ -60,43 +89,60 @@ float gen_power = 0.0;
 float battery_level = 0.0;
 
 static struct etimer green_timer;
+clock_time_t green_interval = GREEN_INTERVAL; // see res-config.c
 static struct etimer sleep_timer;
 static struct etimer error_timer;
 
 // Resources
-extern coap_resource_t res_roomTemp, res_settings;
+extern coap_resource_t res_roomTemp, res_settings, res_diag, res_config;
 
 // Custom events
 static process_event_t green_start_event;
-static process_event_t restart_obs;
+static process_event_t obs_ready_event;
 
 // Process
 PROCESS(hvac_node_process, "HVAC Node Process");
+PROCESS(obs_watchdog_process, "Observation Watchdog");
+#if NODE_BENCH
+PROCESS_NAME(hvac_node_bench_process);
+AUTOSTART_PROCESSES(&hvac_node_bench_process);
+#else
 AUTOSTART_PROCESSES(&hvac_node_process);
+#endif
 
-char* str(float value, char* output)
-{
-    int integer = (int) value;
-    float fraction = value - integer;
-    fraction = fraction < 0 ? -fraction : fraction; // abs
-    int fraction_int = (int)(fraction * 1000);
-    const char* zeros = fraction_int == 0.0 ? "" : 
-                    fraction_int < 10 ? "00" : 
-                    fraction_int < 100 ? "0" : "";
-    int snlen = snprintf(output, 16, "%d.%s%d", integer, zeros, fraction_int);
-    output[snlen] = '\0'; // Ensure null termination
-    return output;
-}
-
-void stop_observation_battery();
-void stop_observation_gen_power();
+// Observed resources of the energy node
+enum observed_id_t { OBS_WEATHER, OBS_BATTERY, OBS_GEN_POWER, OBS_COUNT };
+enum obs_state_t { OBS_STOPPED, OBS_REGISTERING, OBS_OBSERVING, OBS_FAILED };
+
+typedef struct {
+    const char *uri;
+    void (*decode)(coap_message_t *notification, const uint8_t *payload, int len);
+    clock_time_t expected_interval; // longest gap between notifications, Max-Age
+    coap_observee_t *observee;
+    enum obs_state_t state;
+    clock_time_t last_seen;
+    clock_time_t retry_at;
+    uint8_t retries;
+} observed_resource_t;
+
+static void get_value(coap_message_t *notification, const uint8_t *payload, int len);
+
+// To observe a new resource add its id and an entry here
+static observed_resource_t observed[OBS_COUNT] = {
+    [OBS_WEATHER] = { WEATHER_URI, get_value, WEATHER_PMAX },
+    [OBS_BATTERY] = { BATTERY_URI, get_value, BATTERY_PMAX },
+    [OBS_GEN_POWER] = { GEN_POWER_URI, get_value, GEN_POWER_PMAX },
+};
+
+void start_observation(observed_resource_t *res);
+void stop_observation(observed_resource_t *res);
 
 void green_stop()
 {
     cond_mode = MODE_NORMAL; // Reset mode
     etimer_stop(&green_timer); // Stop green mode timer
-    stop_observation_battery(); // Stop battery observation
-    stop_observation_gen_power(); // Stop gen power observation
+    stop_observation(&observed[OBS_BATTERY]); // Stop battery observation
+    stop_observation(&observed[OBS_GEN_POWER]); // Stop gen power observation
 }
 
 void handle_stop()
@@ -133,12 +179,12 @@ void handle_settings(float old_power, enum status_t old_status, enum cond_mode_t
 #endif
 
     // print old and new
-    char old_power_str[16], old_target_temp_str[16];
+    char old_power_str[FMT_FLOAT_BUF_SIZE], old_target_temp_str[FMT_FLOAT_BUF_SIZE];
     LOG_INFO("Old settings: power=%s, status=%d, mode=%d, targetTemp=%s\n",
-             str(old_power, old_power_str), old_status, old_mode, str(old_target_temp, old_target_temp_str));
-    char new_power_str[16], new_target_temp_str[16];
+             fmt_float(old_power, old_power_str), old_status, old_mode, fmt_float(old_target_temp, old_target_temp_str));
+    char new_power_str[FMT_FLOAT_BUF_SIZE], new_target_temp_str[FMT_FLOAT_BUF_SIZE];
     LOG_INFO("New settings: power=%s, status=%d, mode=%d, targetTemp=%s\n",
-             str(conditioner_power, new_power_str), status, cond_mode, str(target_temp, new_target_temp_str));
+             fmt_float(conditioner_power, new_power_str), status, cond_mode, fmt_float(target_temp, new_target_temp_str));
 
     // normal -> green
     if (old_mode == MODE_NORMAL && cond_mode == MODE_GREEN)
@@ -166,103 +212,273 @@ void handle_settings(float old_power, enum status_t old_status, enum cond_mode_t
 // CoAP observation
 static coap_endpoint_t energy_node_endpoint;
 
-static coap_observee_t* weather_obs;
-static coap_observee_t* battery_obs;
-static coap_observee_t* gen_power_obs;
+// Single pass JSON scan of the energy node notifications, in place.
+// Keys and names are matched by FNV-1a hash, numbers (quoted or not) are
+// parsed straight into floats. A value counts only once the character
+// after it has been seen, so a truncated payload updates exactly the
+// fields that arrived complete.
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+#define KEY_N 0xeb0c3431u          // "n"
+#define KEY_V 0xf30c40c9u          // "v"
+#define KEY_OUT_TEMP 0x3761b829u   // "outTemp"
+#define NAME_BATTERY 0xfd6a0c8eu   // "battery"
+#define NAME_GEN_POWER 0xb91089efu // "gen_power"
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} json_scan_t;
+
+static const float json_pow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f };
+
+static void json_skip_ws(json_scan_t *s)
+{
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\r' || *s->p == '\n'))
+        s->p++;
+}
+
+// Hash of a string, the opening quote already consumed
+static bool json_string_hash(json_scan_t *s, uint32_t *hash)
+{
+    uint32_t h = FNV_OFFSET;
+    while (s->p < s->end && *s->p != '"') {
+        if (*s->p == '\\')
+            return false; // escapes are never sent by the energy node
+        h = (h ^ *s->p++) * FNV_PRIME;
+    }
+    if (s->p == s->end)
+        return false;
+    s->p++;
+    *hash = h;
+    return true;
+}
+
+static bool json_number(json_scan_t *s, float *value)
+{
+    bool quoted = s->p < s->end && *s->p == '"';
+    bool negative = false;
+    uint32_t mantissa = 0;
+    int digits = 0, exponent = 0;
+
+    if (quoted)
+        s->p++;
+    if (s->p < s->end && (*s->p == '-' || *s->p == '+'))
+        negative = *s->p++ == '-';
+
+    for (; s->p < s->end && *s->p >= '0' && *s->p <= '9'; s->p++, digits++) {
+        if (mantissa < 100000000u)
+            mantissa = mantissa * 10 + (*s->p - '0');
+        else
+            exponent++; // beyond float precision
+    }
+    if (s->p < s->end && *s->p == '.') {
+        for (s->p++; s->p < s->end && *s->p >= '0' && *s->p <= '9'; s->p++, digits++) {
+            if (mantissa < 100000000u) {
+                mantissa = mantissa * 10 + (*s->p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0)
+        return false;
+
+    if (s->p < s->end && (*s->p == 'e' || *s->p == 'E')) {
+        bool negative_exp = false;
+        int e = 0;
+        s->p++;
+        if (s->p < s->end && (*s->p == '-' || *s->p == '+'))
+            negative_exp = *s->p++ == '-';
+        if (s->p == s->end || *s->p < '0' || *s->p > '9')
+            return false;
+        for (; s->p < s->end && *s->p >= '0' && *s->p <= '9'; s->p++)
+            if (e < 100)
+                e = e * 10 + (*s->p - '0');
+        exponent += negative_exp ? -e : e;
+    }
+
+    if (quoted) {
+        if (s->p == s->end || *s->p != '"')
+            return false;
+        s->p++;
+    }
+    // the number must be complete: the next character has to be there
+    if (s->p == s->end)
+        return false;
+
+    float v = (float) mantissa;
+    for (; exponent > 9; exponent -= 9)
+        v *= json_pow10[9];
+    for (; exponent < -9; exponent += 9)
+        v /= json_pow10[9];
+    v = exponent >= 0 ? v * json_pow10[exponent] : v / json_pow10[-exponent];
+    *value = negative ? -v : v;
+    return true;
+}
+
+// Skips the value of a key we do not use
+static bool json_skip_value(json_scan_t *s)
+{
+    uint32_t hash;
+    if (s->p < s->end && *s->p == '"') {
+        s->p++;
+        return json_string_hash(s, &hash);
+    }
+    while (s->p < s->end && *s->p != ',' && *s->p != '}') {
+        if (*s->p == '{' || *s->p == '[' || *s->p == '"')
+            return false; // nested values are never sent by the energy node
+        s->p++;
+    }
+    return s->p < s->end;
+}
 
 void get_value_from_json(const uint8_t *payload, int len)
 {
-    uint8_t json[COAP_MAX_CHUNK_SIZE];
-    if (len >= COAP_MAX_CHUNK_SIZE)
-        len = COAP_MAX_CHUNK_SIZE - 1;
-    memcpy(json, payload, len);
-    json[len] = '\0';
-    // if {"n" is corrupted, repair it
-    if ((json[0] != '{' || json[1] != '"') && json[2] == 'n') {
+    json_scan_t s = { payload, payload + len };
+    uint32_t name = 0, key;
+    float v = 0.0f, out_temp = 0.0f;
+    bool has_v = false, has_out_temp = false;
+
+    LOG_DBG("Received JSON: %.*s\n", len, (char *)payload);
+
+    // if {"n is corrupted, start from the key
+    if (len > 2 && payload[2] == 'n' && (payload[0] != '{' || payload[1] != '"')) {
         LOG_DBG("Repairing corrupted JSON\n");
-        json[0] = '{';
-        json[1] = '"';
+        s.p = payload + 2;
+    } else {
+        json_skip_ws(&s);
+        if (s.p == s.end || *s.p++ != '{')
+            return;
+        json_skip_ws(&s);
+        if (s.p == s.end || *s.p++ != '"')
+            return;
     }
-    LOG_DBG("Received JSON: %.*s\n", len, (char *)json);
 
-    struct jsonparse_state state;
-    char key[16];
-    char value_str[16];
+    while (json_string_hash(&s, &key)) {
+        json_skip_ws(&s);
+        if (s.p == s.end || *s.p++ != ':')
+            break;
+        json_skip_ws(&s);
+
+        bool ok;
+        if (key == KEY_N) {
+            ok = s.p < s.end && *s.p++ == '"' && json_string_hash(&s, &name) && s.p < s.end;
+        } else if (key == KEY_V) {
+            ok = has_v = json_number(&s, &v);
+        } else if (key == KEY_OUT_TEMP) {
+            ok = has_out_temp = json_number(&s, &out_temp);
+        } else {
+            ok = json_skip_value(&s);
+        }
+        if (!ok)
+            break;
 
-    int next;
-    jsonparse_setup(&state, (char *)json, len);
+        json_skip_ws(&s);
+        if (s.p == s.end || *s.p++ != ',')
+            break; // '}' or garbage, either way nothing follows
+        json_skip_ws(&s);
+        if (s.p == s.end || *s.p++ != '"')
+            break;
+    }
 
-    char name_buf[16] = {0};
-    char value_buf[16] = {0};
-    bool found_name = false;
+    char value_str[FMT_FLOAT_BUF_SIZE];
+    if (has_out_temp) {
+        outTemp = out_temp;
+        LOG_DBG("Weather outTemp updated: %s\n", fmt_float(outTemp, value_str));
+    }
+    if (has_v && name == NAME_BATTERY) {
+        battery_level = v;
+        LOG_DBG("Battery updated: %s\n", fmt_float(battery_level, value_str));
+    } else if (has_v && name == NAME_GEN_POWER) {
+        gen_power = v;
+        LOG_DBG("Gen Power updated: %s\n", fmt_float(gen_power, value_str));
+    }
+}
 
-    while((next = jsonparse_next(&state)) != JSON_TYPE_ERROR) {
-        if(next == JSON_TYPE_PAIR_NAME) {
-            jsonparse_copy_value(&state, key, sizeof(key));
+static bool senml_name_is(const char *s, uint8_t len, const char *name)
+{
+    return strlen(name) == len && memcmp(s, name, len) == 0;
+}
 
-            if(strcmp(key, "n") == 0) {
-                if(jsonparse_next(&state) == JSON_TYPE_STRING) {
-                    jsonparse_copy_value(&state, name_buf, sizeof(name_buf));
-                    found_name = true;
-                }
-            } else if(strcmp(key, "v") == 0 && found_name) {
-                if(jsonparse_next(&state) == JSON_TYPE_STRING || jsonparse_get_type(&state) == JSON_TYPE_NUMBER) {
-                    jsonparse_copy_value(&state, value_buf, sizeof(value_buf));
-                    float v = atof(value_buf);
-
-                    if(strcmp(name_buf, "battery") == 0) {
-                        battery_level = v;
-                        LOG_DBG("Battery updated: %s\n", value_buf);
-                    } else if(strcmp(name_buf, "gen_power") == 0) {
-                        gen_power = v;
-                        LOG_DBG("Gen Power updated: %s\n", value_buf);
-                    }
-                }
-            } else if(strcmp(key, "outTemp") == 0) {
-                if(jsonparse_next(&state) == JSON_TYPE_STRING || jsonparse_get_type(&state) == JSON_TYPE_NUMBER) {
-                    jsonparse_copy_value(&state, value_str, sizeof(value_str));
-                    outTemp = atof(value_str);
-                    LOG_DBG("Weather outTemp updated: %s\n", value_str);
-                }
-            }
-        }
+static void senml_record(const char *base_name, uint8_t base_name_len, const char *name, uint8_t name_len, float value)
+{
+    if (senml_name_is(name, name_len, "outTemp")) {
+        outTemp = value;
+        LOG_DBG("Weather outTemp updated\n");
+    } else if (name_len == 0 && senml_name_is(base_name, base_name_len, "battery")) {
+        battery_level = value;
+        LOG_DBG("Battery updated\n");
+    } else if (name_len == 0 && senml_name_is(base_name, base_name_len, "gen_power")) {
+        gen_power = value;
+        LOG_DBG("Gen Power updated\n");
     }
 }
 
-static bool observing[3] = {false, false, false}; // Weather, Battery, Gen Power
+void get_value_from_senml(const uint8_t *payload, int len)
+{
+    if (senml_cbor_decode(payload, len, senml_record) < 0)
+        LOG_WARN("Malformed SenML-CBOR payload\n");
+}
+
+// The energy node sends JSON unless an observer asked for SenML-CBOR
+static void get_value(coap_message_t *notification, const uint8_t *payload, int len)
+{
+    unsigned int format = APPLICATION_JSON;
+
+    if (notification)
+        coap_get_header_content_format(notification, &format);
+    if (format == SENML_CBOR_CONTENT_FORMAT)
+        get_value_from_senml(payload, len);
+    else
+        get_value_from_json(payload, len);
+}
+
+// Schedule a new registration after a jittered exponential backoff
+static void retry_observation(observed_resource_t *res)
+{
+    clock_time_t backoff = OBS_BACKOFF_MIN << (res->retries < 5 ? res->retries : 5);
+    if (backoff > OBS_BACKOFF_MAX)
+        backoff = OBS_BACKOFF_MAX;
+    backoff = backoff / 2 + random_rand() % (backoff / 2 + 1);
+
+    res->state = OBS_FAILED;
+    res->retry_at = clock_time() + backoff;
+    if (res->retries < UINT8_MAX)
+        res->retries++;
+    LOG_INFO("Registering %s again in %lu ms\n", res->uri, (unsigned long) (backoff * 1000 / CLOCK_SECOND));
+}
 
 /* COAP Notification handler*/
 static void notification_callback(coap_observee_t* obs, void* notification, coap_notification_flag_t flag)
 {
+    observed_resource_t *res = (observed_resource_t *) obs->data;
     int len = 0;
     const uint8_t* payload = NULL;
+    uint32_t max_age;
 
     if (notification) {
         len = coap_get_payload(notification, &payload);
     }
     switch(flag) {
-        case NOTIFICATION_OK:
-            LOG_DBG("Received %s\n", (char *)payload);
-            get_value_from_json(payload, len);
-            if (strcmp(obs->url, WEATHER_URI) == 0)
-                observing[0] = true;
-            else if (strcmp(obs->url, BATTERY_URI) == 0)
-                observing[1] = true;
-            else if (strcmp(obs->url, GEN_POWER_URI) == 0)
-                observing[2] = true;
-            break;
         case OBSERVE_OK: /* server accepeted observation request */
-            LOG_INFO("%s accepted observe request\n", obs->url);
-            get_value_from_json(payload, len);
-            if (strcmp(obs->url, WEATHER_URI) == 0)
-                observing[0] = true;
-            else if (strcmp(obs->url, BATTERY_URI) == 0)
-                observing[1] = true;
-            else if (strcmp(obs->url, GEN_POWER_URI) == 0)
-                observing[2] = true;
+            LOG_INFO("%s accepted observe request\n", res->uri);
+            /* fall through */
+        case NOTIFICATION_OK:
+            res->decode(notification, payload, len);
+            res->last_seen = clock_time();
+            if (notification && coap_get_header_max_age(notification, &max_age))
+                res->expected_interval = (clock_time_t) (max_age < OBS_MAX_AGE_LIMIT ? max_age : OBS_MAX_AGE_LIMIT) * CLOCK_SECOND;
+            res->retries = 0;
+            if (res->state != OBS_OBSERVING) {
+                res->state = OBS_OBSERVING;
+                process_post(&hvac_node_process, obs_ready_event, res);
+            }
             break;
         case OBSERVE_NOT_SUPPORTED:
-            LOG_WARN("%s does not support observation\n", obs->url);
+            LOG_WARN("%s does not support observation\n", res->uri);
+            res->observee = NULL; // freed by the client library
+            res->state = OBS_FAILED;
             status = STATUS_ERROR;
             handle_stop();
             LOG_ERR("HVAC system in error state.\n");
@@ -271,69 +487,238 @@ static void notification_callback(coap_observee_t* obs, void* notification, coap
         case NO_REPLY_FROM_SERVER:
             LOG_WARN("%s did not reply: "
                     "removing observe registration with token %x%x\n",
-                    obs->url, obs->token[0], obs->token[1]);
-            process_post(&hvac_node_process, restart_obs, obs);
-            if (strcmp(obs->url, WEATHER_URI) == 0)
-                observing[0] = false;
-            else if (strcmp(obs->url, BATTERY_URI) == 0)
-                observing[1] = false;
-            else if (strcmp(obs->url, GEN_POWER_URI) == 0)
-                observing[2] = false;
+                    res->uri, obs->token[0], obs->token[1]);
+            // the client library frees the observee: its slot can be reused
+            res->observee = NULL;
+            retry_observation(res);
             break;
     }
 }
 
-
-void start_observation_weather()
+void start_observation(observed_resource_t *res)
 {
-    LOG_INFO("Starting weather observation\n");
-    coap_obs_remove_observee(weather_obs);
-    weather_obs = coap_obs_request_registration(
-        &energy_node_endpoint, WEATHER_URI, notification_callback, NULL
+    LOG_INFO("Starting %s observation\n", res->uri);
+    if (res->observee)
+        coap_obs_remove_observee(res->observee);
+    res->state = OBS_REGISTERING;
+    res->last_seen = clock_time(); // start of the registration
+    res->observee = coap_obs_request_registration(
+        &energy_node_endpoint, (char *) res->uri, notification_callback, res
     );
 }
 
-void start_observation_battery()
+void stop_observation(observed_resource_t *res)
 {
-    LOG_INFO("Starting battery observation\n");
-    coap_obs_remove_observee(battery_obs);
-    battery_obs = coap_obs_request_registration(
-        &energy_node_endpoint, BATTERY_URI, notification_callback, NULL
-    );
+    LOG_INFO("Stopping %s observation\n", res->uri);
+    if (res->observee)
+        coap_obs_remove_observee(res->observee);
+    res->observee = NULL;
+    res->state = OBS_STOPPED;
+    res->retries = 0;
 }
 
-void start_observation_gen_power()
+static bool observing(enum observed_id_t id)
 {
-    LOG_INFO("Starting gen power observation\n");
-    coap_obs_remove_observee(gen_power_obs);
-    gen_power_obs = coap_obs_request_registration(
-        &energy_node_endpoint, GEN_POWER_URI, notification_callback, NULL
-    );
+    return observed[id].state == OBS_OBSERVING;
 }
 
-void stop_observation_battery()
+// Detects observations gone silent and registers failed ones again
+PROCESS_THREAD(obs_watchdog_process, ev, data)
 {
-    LOG_INFO("Stopping battery observation\n");
-    coap_obs_remove_observee(battery_obs);
-    observing[1] = false;
-}
+    static struct etimer watchdog_timer;
 
-void stop_observation_gen_power()
-{
-    LOG_INFO("Stopping gen power observation\n");
-    coap_obs_remove_observee(gen_power_obs);
-    observing[2] = false;
+    PROCESS_BEGIN();
+
+    etimer_set(&watchdog_timer, OBS_WATCHDOG_INTERVAL);
+
+    while(1) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&watchdog_timer));
+        clock_time_t now = clock_time();
+
+        for (int i = 0; i < OBS_COUNT; i++) {
+            observed_resource_t *res = &observed[i];
+
+            if (res->state == OBS_OBSERVING
+                && now - res->last_seen > OBS_STALE_FACTOR * res->expected_interval) {
+                LOG_WARN("%s silent for %lu s, observation lost\n",
+                         res->uri, (unsigned long) ((now - res->last_seen) / CLOCK_SECOND));
+                retry_observation(res);
+            } else if (res->state == OBS_REGISTERING
+                       && now - res->last_seen > OBS_REGISTER_TIMEOUT) {
+                LOG_WARN("%s registration not answered\n", res->uri);
+                retry_observation(res);
+            } else if (res->state == OBS_FAILED && !CLOCK_LT(now, res->retry_at)) {
+                start_observation(res);
+            }
+        }
+
+        etimer_reset(&watchdog_timer);
+    }
+
+    PROCESS_END();
 }
 
 void client_chunk_handler(coap_callback_request_state_t *state){
     return;
 }
 
+// Relay POST payload: n=relay&r_sp=..&r_h=..&p_sp=..&p_h=..
+static void relay_payload(char* payload, enum relay_sp_t r_sp, enum relay_home_t r_h, float p_sp, float p_h)
+{
+    char *p = fmt_str(payload, "n=relay&r_sp=");
+    p = fmt_int(p, r_sp);
+    p = fmt_str(p, "&r_h=");
+    p = fmt_int(p, r_h);
+    p = fmt_str(p, "&p_sp=");
+    p = fmt_fixed(p, p_sp, FMT_PRECISION);
+    p = fmt_str(p, "&p_h=");
+    fmt_fixed(p, p_h, FMT_PRECISION);
+}
+
 static coap_callback_request_state_t req_state;
+static bool green_waiting_obs = false; // green step skipped, observations not ready
+
+// CPU time of the control cycle branches, see diag/energest
+profile_t profile_roomTemp = { "roomTemp" };
+profile_t profile_green = { "green" };
+
+// Green mode step: share the needed power between solar panels and battery
+static void green_step()
+{
+    if (status == STATUS_OFF || status == STATUS_ERROR) {
+        LOG_INFO("Cannot start green mode, HVAC is off or in error state.\n");
+        return;
+    }
+
+    if (!observing(OBS_WEATHER) || !observing(OBS_BATTERY) || !observing(OBS_GEN_POWER)) {
+        LOG_INFO("Green mode: waiting observe registration\n");
+        LOG_DBG("Observing: %d, %d, %d\n",
+            observing(OBS_WEATHER), observing(OBS_BATTERY), observing(OBS_GEN_POWER));
+        green_waiting_obs = true;
+        return;
+    }
+
+    float needed_power;
+    bool green_vent = false;
+
+    if (status == STATUS_VENT) {
+        needed_power = VENT_POWER;
+        green_vent = true;
+    }
+    else
+    {
+        if ((status == STATUS_COOL && roomTemp <= target_temp)
+            || (status == STATUS_HEAT && roomTemp >= target_temp)) 
+        {
+            LOG_INFO("Target temperature reached, HVAC suspended\n");
+            needed_power = 0.0;
+        } 
+        else 
+        {
+            needed_power = (0.2 * (target_temp - roomTemp) / SECONDS) - (outTemp - roomTemp) * deltat_coeff;
+            needed_power /= power_coeff;
+            if (status == STATUS_COOL)
+                needed_power = -needed_power; // Cool mode uses negative power
+
+            if (needed_power < 0.0)
+                needed_power = 0.0; // No need for power if cooling is not needed
+        }
+    }
+
+    char needed_power_str[FMT_FLOAT_BUF_SIZE], gen_power_str[FMT_FLOAT_BUF_SIZE], battery_level_str[FMT_FLOAT_BUF_SIZE];
+    LOG_INFO("Green mode: needed power = %sW, gen power = %sW, battery level = %sWh\n",
+             fmt_float(needed_power, needed_power_str), fmt_float(gen_power, gen_power_str), fmt_float(battery_level, battery_level_str));
+
+    coap_message_t request[1];
+    coap_init_message(request, COAP_TYPE_CON, COAP_POST, 0);
+    coap_set_header_uri_path(request, RELAY_URI);
+
+    char payload[COAP_MAX_CHUNK_SIZE];
+    // compare with gen_power
+    if (needed_power > 0.0 && needed_power <= gen_power) 
+    {
+        relay_payload(payload, RELAY_SP_HOME, RELAY_HOME_SP, needed_power, needed_power); // Ask needed power to energy node
+        conditioner_power = needed_power; // Update conditioner power
+    }
+    else
+    {
+        // try with the battery
+        float dc_needed_power = needed_power * DC_AC_COEFF;
+        if (needed_power == 0.0 || dc_needed_power * GREEN_HOURS <= battery_level - 20.0) // battery is enough
+        {
+            relay_payload(payload, RELAY_SP_BATTERY, RELAY_HOME_BATTERY, gen_power, needed_power); // Ask needed power to energy node
+            conditioner_power = needed_power;
+        }
+        else // not enough power
+        {
+            // if cool, try vent
+            if (status == STATUS_COOL)
+            {
+                // gen_power is enough
+                if (VENT_POWER <= gen_power)
+                {
+                    relay_payload(payload, RELAY_SP_HOME, RELAY_HOME_SP, VENT_POWER, VENT_POWER); // Ask vent power to energy node
+                    conditioner_power = VENT_POWER;
+                    green_vent = true;
+                }
+                else
+                {
+                    // try with the battery
+                    float dc_needed_power = VENT_POWER * DC_AC_COEFF;
+                    if (dc_needed_power * GREEN_HOURS <= battery_level) // battery is enough
+                    {
+                        relay_payload(payload, RELAY_SP_BATTERY, RELAY_HOME_BATTERY, gen_power, VENT_POWER); // Ask vent power to energy node
+                            conditioner_power = VENT_POWER;
+                            green_vent = true;
+                    }
+                    else // not enough in any case
+                    {
+                        relay_payload(payload, RELAY_SP_BATTERY, RELAY_HOME_BATTERY, gen_power, 0.0); // Ask vent power to energy node
+                            conditioner_power = 0.0;
+                    }
+                }
+            }
+            else // not enough in any case
+            {
+                relay_payload(payload, RELAY_SP_BATTERY, RELAY_HOME_BATTERY, gen_power, 0.0); // Ask vent power to energy node
+                    conditioner_power = 0.0;
+            }
+        }
+    }
+    enum status_t actual_status = status;
+    status = green_vent ? STATUS_VENT : status;
+
+    char power_str[FMT_FLOAT_BUF_SIZE], target_temp_str[FMT_FLOAT_BUF_SIZE];
+    LOG_INFO("Green mode new settings: power=%s, status=%d, mode=%d, targetTemp=%s\n",
+    fmt_float(conditioner_power, power_str), status, cond_mode, fmt_float(target_temp, target_temp_str));
+
+    coap_set_payload(request, (uint8_t *) payload, strlen(payload));
+    coap_send_request(&req_state, &energy_node_endpoint, request, client_chunk_handler);
+    LOG_DBG("Green mode request sent: %s\n", payload);
+
+    res_settings.trigger(); // Trigger settings resource update
+    status = actual_status;
+
+    #if PLATFORM_HAS_LEDS || LEDS_COUNT
+        if (conditioner_power > 0.0)
+            leds_single_on(LEDS_YELLOW); // Indicate green mode active
+        else
+            leds_single_off(LEDS_YELLOW); // Turn off yellow LED
+    #endif
+}
+
+// green_step() timed for diag/energest
+static void green_update()
+{
+    rtimer_clock_t start = profile_start();
+    green_step();
+    profile_stop(&profile_green, start);
+}
 
 PROCESS_THREAD(hvac_node_process, ev, data) 
 {
     static struct etimer rootTemp_timer;
+    static bool restored = false; // state of the checkpoint
 
     PROCESS_BEGIN();
 
@@ -347,16 +732,22 @@ PROCESS_THREAD(hvac_node_process, ev, data)
 
     LOG_INFO("Starting hvac node\n");
 
+    // Saved control parameters and state (warm restart)
+    config_load(&node_config);
+    restored = checkpoint_restore(checkpoints) > 0;
+
     // Initialize resources
     coap_activate_resource(&res_roomTemp, "sensors/roomTemp");
     coap_activate_resource(&res_settings, "settings");
+    coap_activate_resource(&res_diag, "diag");
+    coap_activate_resource(&res_config, "config");
 
     // Initialize CoAP endpoint
     coap_endpoint_parse(ENERGY_NODE_EP, strlen(ENERGY_NODE_EP), &energy_node_endpoint);
 
     // Initialize events
     green_start_event = process_alloc_event();
-    restart_obs = process_alloc_event();
+    obs_ready_event = process_alloc_event();
 
     // Wait connection
     while (!coap_endpoint_is_connected(&energy_node_endpoint)) {
@@ -382,7 +773,12 @@ PROCESS_THREAD(hvac_node_process, ev, data)
     #endif
 
     // Initialize observations
-    start_observation_weather();
+    start_observation(&observed[OBS_WEATHER]);
+    process_start(&obs_watchdog_process, NULL);
+
+    // Resume the restored settings (green mode), as if just set
+    if (restored)
+        handle_settings(0.0, STATUS_OFF, MODE_NORMAL, target_temp);
 
     // Initialize timers
     etimer_set(&rootTemp_timer, SHORT_INTERVAL);
@@ -394,8 +790,10 @@ PROCESS_THREAD(hvac_node_process, ev, data)
         {
             if (data == &rootTemp_timer) {
                 // Trigger rootTemp resources
+                rtimer_clock_t start = profile_start();
                 res_roomTemp.trigger();
-                etimer_reset(&rootTemp_timer);
+                etimer_set(&rootTemp_timer, roomTemp_sample_interval()); // adaptive
+                profile_stop(&profile_roomTemp, start);
             }
             else if (data == &error_timer) {
         #if PLATFORM_HAS_LEDS || LEDS_COUNT
@@ -413,181 +811,30 @@ PROCESS_THREAD(hvac_node_process, ev, data)
                     handle_stop();
                     continue;
                 }
-
-                if (status == STATUS_OFF || status == STATUS_ERROR) {
-                    LOG_INFO("Cannot start green mode, HVAC is off or in error state.\n");
-                    etimer_reset(&green_timer);
-                    continue;
-                }
-
-                if (!observing[0] || !observing[1] || !observing[2]) {
-                    LOG_INFO("Green mode: waiting observe registration\n");
-                    LOG_DBG("Observing: %d, %d, %d\n",
-                        observing[0], observing[1], observing[2]);
-                    etimer_reset(&green_timer);
-                    continue;
-                }
-
-                float needed_power;
-                bool green_vent = false;
-
-                if (status == STATUS_VENT) {
-                    needed_power = VENT_POWER;
-                    green_vent = true;
-                }
-                else
-                {
-                    if ((status == STATUS_COOL && roomTemp <= target_temp)
-                        || (status == STATUS_HEAT && roomTemp >= target_temp)) 
-                    {
-                        LOG_INFO("Target temperature reached, HVAC suspended\n");
-                        needed_power = 0.0;
-                    } 
-                    else 
-                    {
-                        needed_power = (0.2 * (target_temp - roomTemp) / SECONDS) - (outTemp - roomTemp) * DELTAT_COEFF;
-                        needed_power /= POWER_COEFF;
-                        if (status == STATUS_COOL)
-                            needed_power = -needed_power; // Cool mode uses negative power
-    
-                        if (needed_power < 0.0)
-                            needed_power = 0.0; // No need for power if cooling is not needed
-                    }
-                }
-
-                char needed_power_str[16], gen_power_str[16], battery_level_str[16];
-                LOG_INFO("Green mode: needed power = %sW, gen power = %sW, battery level = %sWh\n",
-                         str(needed_power, needed_power_str), str(gen_power, gen_power_str), str(battery_level, battery_level_str));
-
-                coap_message_t request[1];
-                coap_init_message(request, COAP_TYPE_CON, COAP_POST, 0);
-                coap_set_header_uri_path(request, RELAY_URI);
-
-                char payload[COAP_MAX_CHUNK_SIZE];
-                char buf[16], buf2[16];
-                // compare with gen_power
-                if (needed_power > 0.0 && needed_power <= gen_power) 
-                {
-                    int snlen = snprintf(payload, // Ask needed power to energy node
-                        COAP_MAX_CHUNK_SIZE,
-                        "n=relay&r_sp=%d&r_h=%d&p_sp=%s&p_h=%s",
-                        (int) RELAY_SP_HOME, (int) RELAY_HOME_SP, str(needed_power, buf), str(needed_power, buf2));
-                    payload[snlen] = '\0'; // Ensure null termination
-                    conditioner_power = needed_power; // Update conditioner power
-                }
-                else
-                {
-                    // try with the battery
-                    float dc_needed_power = needed_power * DC_AC_COEFF;
-                    if (needed_power == 0.0 || dc_needed_power * GREEN_HOURS <= battery_level - 20.0) // battery is enough
-                    {
-                        int snlen = snprintf(payload, // Ask needed power to energy node
-                            COAP_MAX_CHUNK_SIZE,
-                            "n=relay&r_sp=%d&r_h=%d&p_sp=%s&p_h=%s",
-                            (int) RELAY_SP_BATTERY, (int) RELAY_HOME_BATTERY, str(gen_power, buf), str(needed_power, buf2));
-                        payload[snlen] = '\0'; // Ensure null termination
-                        conditioner_power = needed_power;
-                    }
-                    else // not enough power
-                    {
-                        // if cool, try vent
-                        if (status == STATUS_COOL)
-                        {
-                            // gen_power is enough
-                            if (VENT_POWER <= gen_power)
-                            {
-                                int snlen = snprintf(payload, // Ask vent power to energy node
-                                    COAP_MAX_CHUNK_SIZE,
-                                    "n=relay&r_sp=%d&r_h=%d&p_sp=%s&p_h=%s",
-                                    (int) RELAY_SP_HOME, (int) RELAY_HOME_SP, str(VENT_POWER, buf), str(VENT_POWER, buf2));
-                                payload[snlen] = '\0'; // Ensure null termination
-                                conditioner_power = VENT_POWER;
-                                green_vent = true;
-                            }
-                            else
-                            {
-                                // try with the battery
-                                float dc_needed_power = VENT_POWER * DC_AC_COEFF;
-                                if (dc_needed_power * GREEN_HOURS <= battery_level) // battery is enough
-                                {
-                                    int snlen = snprintf(payload, // Ask vent power to energy node
-                                        COAP_MAX_CHUNK_SIZE,
-                                        "n=relay&r_sp=%d&r_h=%d&p_sp=%s&p_h=%s",
-                                        (int) RELAY_SP_BATTERY, (int) RELAY_HOME_BATTERY, str(gen_power, buf), str(VENT_POWER, buf2));
-                                    payload[snlen] = '\0'; // Ensure null termination
-                                        conditioner_power = VENT_POWER;
-                                        green_vent = true;
-                                }
-                                else // not enough in any case
-                                {
-                                    int snlen = snprintf(payload, // Ask vent power to energy node
-                                        COAP_MAX_CHUNK_SIZE,
-                                        "n=relay&r_sp=%d&r_h=%d&p_sp=%s&p_h=%s",
-                                        (int) RELAY_SP_BATTERY, (int) RELAY_HOME_BATTERY, str(gen_power, buf), str(0.0, buf2));
-                                    payload[snlen] = '\0'; // Ensure null termination
-                                        conditioner_power = 0.0;
-                                }
-                            }
-                        }
-                        else // not enough in any case
-                        {
-                            int snlen = snprintf(payload, // Ask vent power to energy node
-                                COAP_MAX_CHUNK_SIZE,
-                                "n=relay&r_sp=%d&r_h=%d&p_sp=%s&p_h=%s",
-                                (int) RELAY_SP_BATTERY, (int) RELAY_HOME_BATTERY, str(gen_power, buf), str(0.0, buf2));
-                            payload[snlen] = '\0'; // Ensure null termination
-                                conditioner_power = 0.0;
-                        }
-                    }
-                }
-                enum status_t actual_status = status;
-                status = green_vent ? STATUS_VENT : status;
-
-                char power_str[16], target_temp_str[16];
-                LOG_INFO("Green mode new settings: power=%s, status=%d, mode=%d, targetTemp=%s\n",
-                str(conditioner_power, power_str), status, cond_mode, str(target_temp, target_temp_str));
-
-                coap_set_payload(request, (uint8_t *) payload, strlen(payload));
-                coap_send_request(&req_state, &energy_node_endpoint, request, client_chunk_handler);
-                LOG_DBG("Green mode request sent: %s\n", payload);
-
-                res_settings.trigger(); // Trigger settings resource update
-                status = actual_status;
-
-                #if PLATFORM_HAS_LEDS || LEDS_COUNT
-                    if (conditioner_power > 0.0)
-                        leds_single_on(LEDS_YELLOW); // Indicate green mode active
-                    else
-                        leds_single_off(LEDS_YELLOW); // Turn off yellow LED
-                #endif
-
+                green_update();
                 // Reset the timer for the next green mode check
-                etimer_reset(&green_timer);
+                etimer_reset_with_new_interval(&green_timer, green_interval);
             }
         }
         // Handle green mode
         else if (ev == green_start_event)
         {
             // start observations
-            start_observation_battery();
-            start_observation_gen_power();
+            start_observation(&observed[OBS_BATTERY]);
+            start_observation(&observed[OBS_GEN_POWER]);
 
-            etimer_set(&green_timer, GREEN_INTERVAL);
+            // first step as soon as the registrations are accepted
+            green_waiting_obs = true;
+            etimer_set(&green_timer, green_interval);
         }
-        // restart failed observation
-        else if (ev == restart_obs)
+        // observation (re)established, run a green step skipped while waiting
+        else if (ev == obs_ready_event)
         {
-            // data is the observee that failed
-            coap_observee_t* obs = (coap_observee_t*) data;
-            LOG_DBG("Restarting observation for %s\n", obs->url);
-            if (strcmp(obs->url, WEATHER_URI) == 0) {
-                start_observation_weather();
-            } else if (strcmp(obs->url, BATTERY_URI) == 0) {
-                start_observation_battery();
-            } else if (strcmp(obs->url, GEN_POWER_URI) == 0) {
-                start_observation_gen_power();
-            } else {
-                LOG_ERR("Unknown observee URL: %s\n", obs->url);
+            if (cond_mode == MODE_GREEN && green_waiting_obs
+                && observing(OBS_WEATHER) && observing(OBS_BATTERY) && observing(OBS_GEN_POWER)) {
+                green_waiting_obs = false;
+                green_update();
+                etimer_restart(&green_timer);
             }
         }
 #if PLATFORM_HAS_BUTTON
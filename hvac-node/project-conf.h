@@ -55,6 +55,13 @@
 
 #define COAP_OBSERVE_CLIENT     1
 
+// CPU, low power mode and radio times for diag/energest
+#define ENERGEST_CONF_ON 1
+
+#if NODE_BENCH
+#define LOG_LEVEL_APP LOG_LEVEL_WARN
+#else
 #define LOG_LEVEL_APP LOG_LEVEL_INFO
+#endif
 
 #endif /* PROJECT_CONF_H_ */
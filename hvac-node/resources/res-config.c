@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "node-config.h"
+#include "adaptive-sampler.h"
+#include "profile.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "CONFIG"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+// external resources
+extern clock_time_t green_interval;
+extern float deltat_coeff, power_coeff;
+extern adaptive_sampler_t roomTemp_sampler;
+
+// Control parameters of the hvac node
+static const config_entry_t entries[] = {
+    { "green_interval", CONFIG_INTERVAL, &green_interval, 1, 3600 },
+    { "deltat_coeff", CONFIG_FLOAT, &deltat_coeff, 0, 1 },
+    { "power_coeff", CONFIG_FLOAT, &power_coeff, 0.00001, 0.01 },
+    { "roomTemp_smin", CONFIG_INTERVAL, &roomTemp_sampler.min_interval, 1, 3600 },
+    { "roomTemp_smax", CONFIG_INTERVAL, &roomTemp_sampler.max_interval, 1, 3600 },
+};
+
+static bool config_check(void)
+{
+    return roomTemp_sampler.min_interval <= roomTemp_sampler.max_interval;
+}
+
+const config_t node_config = {
+    "config", entries, sizeof(entries) / sizeof(entries[0]), config_check, NULL
+};
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+static void res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(config_get, res_get_handler)
+LATENCY_HANDLER(config_put, res_put_handler)
+
+RESOURCE(res_config,
+         "title=\"Configuration (PUT name=value&..., SenML-CBOR)\";rt=\"Config\"",
+         res_get_handler_timed,
+         NULL,
+         res_put_handler_timed,
+         NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    config_get_handler(&node_config, request, response, buffer, preferred_size, offset);
+    LOG_DBG("config resource GET handler called\n");
+}
+
+static void res_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    config_put_handler(&node_config, request, response);
+    LOG_DBG("config resource PUT handler called\n");
+}
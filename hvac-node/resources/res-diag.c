@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "notify-policy.h"
+#include "adaptive-sampler.h"
+#include "coap-chunked.h"
+#include "profile.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "DIAG"
+#define LOG_LEVEL LOG_LEVEL_APP
+
+#define DIAG_URI "diag"
+
+// external resources
+extern notify_delivery_t roomTemp_delivery, settings_delivery;
+extern adaptive_sampler_t roomTemp_sampler;
+extern profile_t profile_roomTemp, profile_green;
+extern latency_t latency_roomTemp_get, latency_roomTemp_event, latency_settings_get,
+    latency_settings_post, latency_settings_event, latency_config_get, latency_config_put, latency_diag_get;
+
+profile_t profile_json = { "json" }; // GET and notification payloads
+
+// notifications per message type and their delivery
+static void delivery_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[80];
+
+    coap_chunked_put(out, "{\"n\":\"delivery\",");
+    notify_delivery_json(buffer, "roomTemp", &roomTemp_delivery);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, ",");
+    notify_delivery_json(buffer, "settings", &settings_delivery);
+    coap_chunked_put(out, buffer);
+    coap_chunked_put(out, "}");
+}
+
+// node times and CPU time of the control cycle branches and hot paths
+static void energest_generator(coap_chunked_t *out, void *data)
+{
+    static profile_t *const profiles[] = { &profile_roomTemp, &profile_green, &profile_json, NULL };
+    profile_energest_json(out, profiles);
+}
+
+// adaptive sampling of the room temperature
+static void sampler_generator(coap_chunked_t *out, void *data)
+{
+    char buffer[80];
+    char *p = fmt_str(buffer, "{\"n\":\"sampler\",");
+    p = adaptive_sampler_json(p, "roomTemp", &roomTemp_sampler);
+    fmt_str(p, "}");
+    coap_chunked_put(out, buffer);
+}
+
+// handler latency histograms
+static void latency_generator(coap_chunked_t *out, void *data)
+{
+    static latency_t *const latencies[] = {
+        &latency_roomTemp_get, &latency_roomTemp_event, &latency_settings_get,
+        &latency_settings_post, &latency_settings_event, &latency_config_get, &latency_config_put,
+        &latency_diag_get, NULL
+    };
+    latency_json(out, latencies);
+}
+
+// sub-resources, served in Block2 chunks
+static const struct {
+    const char *name;
+    coap_chunked_generator_t generator;
+} diags[] = {
+    { "delivery", delivery_generator },
+    { "energest", energest_generator },
+    { "latency", latency_generator },
+    { "sampler", sampler_generator },
+};
+
+// RESOURCE definition
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
+
+// handler latencies, see diag/latency
+LATENCY_HANDLER(diag_get, res_get_handler)
+
+PARENT_RESOURCE(res_diag,
+                "title=\"Diagnostics (diag/delivery|energest|latency|sampler)\";rt=\"Diag\"",
+                res_get_handler_timed,
+                NULL,
+                NULL,
+                NULL);
+
+static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+    const char *uri = NULL;
+    int len = coap_get_header_uri_path(request, &uri);
+
+    // sub-resource name after "diag/"
+    const char *sub = uri + sizeof(DIAG_URI);
+    len -= sizeof(DIAG_URI);
+
+    for (int i = 0; i < sizeof(diags) / sizeof(diags[0]); i++) {
+        if (len == (int) strlen(diags[i].name) && strncmp(sub, diags[i].name, len) == 0) {
+            coap_chunked_respond(response, buffer, preferred_size, offset, APPLICATION_JSON, diags[i].generator, NULL);
+            coap_chunked_set_period_etag(response); // live counters
+            LOG_DBG("diag resource GET handler called\n");
+            return;
+        }
+    }
+
+    LOG_DBG("Unknown diagnostic resource: %.*s\n", len > 0 ? len : 0, sub);
+    coap_set_status_code(response, NOT_FOUND_4_04);
+}
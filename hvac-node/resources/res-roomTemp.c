@@ -3,6 +3,13 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "adaptive-sampler.h"
+#include "profile.h"
+#include "checkpoint.h"
+#include "../checkpoint-ids.h"
 #include "random.h"
 #include "sys/clock.h"
 #include "sys/log.h"
@@ -14,36 +21,66 @@
 #define MAX_POWER 3000.0 // W
 
 // T_new = T_old + (deltaT * c1 - power * c2) * elapsed_time
-// Temperature parameters
+// Temperature parameters, defaults of the config resource
 #define DELTAT_COEFF 0.02
 #define POWER_COEFF 0.0004
 #define MAX_RANDOM_OFFSET 0.1
 #define MIN_TEMP 0.0
 #define MAX_TEMP 50.0
 
+// Adaptive sampling, see adaptive-sampler.h: faster while the temperature
+// moves or gets close to the target
+#define ROOMTEMP_SAMPLE_STEP 0.2 // °C
+#ifdef ROOMTEMP_CONF_SAMPLE_MIN
+#define ROOMTEMP_SAMPLE_MIN ROOMTEMP_CONF_SAMPLE_MIN
+#else
+#define ROOMTEMP_SAMPLE_MIN (CLOCK_SECOND * 2)
+#endif
+#ifdef ROOMTEMP_CONF_SAMPLE_MAX
+#define ROOMTEMP_SAMPLE_MAX ROOMTEMP_CONF_SAMPLE_MAX
+#else
+#define ROOMTEMP_SAMPLE_MAX (CLOCK_SECOND * 30)
+#endif
+
 // external resources
 extern float conditioner_power; // Power of the conditioner in W
 extern float outTemp;
 enum status_t {STATUS_OFF, STATUS_VENT, STATUS_COOL, STATUS_HEAT, STATUS_ERROR};
 extern enum status_t status;
+extern float target_temp;
 
 float roomTemp = 28.0;
 float lastUpdateTime = 0.0;
+float deltat_coeff = DELTAT_COEFF;
+float power_coeff = POWER_COEFF;
+
+// Kept across reboots, see checkpoint.h: the room model, not its update
+// time, which is uptime
+checkpoint_item_t roomTemp_checkpoint = { CKPT_ROOMTEMP, 1, CLOCK_SECOND * 60, {
+    { &roomTemp, sizeof(roomTemp) },
+} };
+
+adaptive_sampler_t roomTemp_sampler = { ROOMTEMP_SAMPLE_STEP, ROOMTEMP_SAMPLE_MIN, ROOMTEMP_SAMPLE_MAX };
+
+// Interval to the next room temperature sample
+clock_time_t roomTemp_sample_interval()
+{
+    return roomTemp_sampler.interval != 0 ? roomTemp_sampler.interval : ROOMTEMP_SAMPLE_MIN;
+}
 
-char* str(float value, char* output);
 
-static void update_roomTemp()
+void update_roomTemp()
 {
     if (lastUpdateTime == 0.0)
         lastUpdateTime = clock_seconds();
     unsigned long currentTime = clock_seconds();
     unsigned long elapsedTime = currentTime - lastUpdateTime;
 
-    float outside_contribution = (float) DELTAT_COEFF * (float)(outTemp - roomTemp);
+    float outside_contribution = deltat_coeff * (float)(outTemp - roomTemp);
     float conditioner_contribution = 
         (status == STATUS_OFF || status == STATUS_VENT || status == STATUS_ERROR) ? 0.0 :
-        (status == STATUS_COOL) ? -conditioner_power * POWER_COEFF :
-        (status == STATUS_HEAT) ? conditioner_power * POWER_COEFF : 
+        (status == STATUS_COOL) ? -conditioner_power * power_coeff :
+        (status == STATUS_HEAT) ? conditioner_power * power_coeff : 
         0.0;
 
     // Update room temperature
@@ -63,52 +100,87 @@ static void update_roomTemp()
     }
 
     lastUpdateTime = currentTime;
+    checkpoint_save(&roomTemp_checkpoint);
 
-    char roomTemp_str[16];
-    char outcont[16], condcont[16];
+    char roomTemp_str[FMT_FLOAT_BUF_SIZE];
+    char outcont[FMT_FLOAT_BUF_SIZE], condcont[FMT_FLOAT_BUF_SIZE];
     LOG_INFO("Room temperature update: outside_contribution=%s, conditioner_contribution=%s\n",
-            str(outside_contribution, outcont), str(conditioner_contribution, condcont));
+            fmt_float(outside_contribution, outcont), fmt_float(conditioner_contribution, condcont));
     LOG_INFO("New room temperature: roomTemp=%s°C, elapsed=%d\n",
-            str(roomTemp, roomTemp_str), (int) elapsedTime);
+            fmt_float(roomTemp, roomTemp_str), (int) elapsedTime);
 }
 
 void roomTemp_json_string(char* buffer)
 {
-    char buf1[16];
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE,
-            "{\"n\":\"roomTemp\",\"v\":%s}",
-            str(roomTemp, buf1));
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"roomTemp\",\"v\":");
+    p = fmt_fixed(p, roomTemp, FMT_PRECISION);
+    fmt_str(p, "}");
+}
+
+int roomTemp_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 1);
+    p = senml_cbor_record(p, "roomTemp", NULL, roomTemp);
+    return p - buffer;
 }
 
+// Notification delivery: telemetry, non-confirmable
+notify_delivery_t roomTemp_delivery = { false };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(roomTemp_get, res_get_handler)
+LATENCY_EVENT_HANDLER(roomTemp_event, res_event_handler)
+
 EVENT_RESOURCE(res_roomTemp,
                 "title=\"Room temperature\";rt=\"Sensor\";obs",
-                res_get_handler,
+                res_get_handler_timed,
                 NULL,
                 NULL,
                 NULL,                
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    roomTemp_json_string((char *)buffer);
-
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    if (offset == NULL)
+        notify_delivery_prepare(&roomTemp_delivery, response);
+
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, roomTemp_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        roomTemp_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+        LOG_DBG("Sending roomTemp: %s°C\n", (char *)buffer);
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("Room temperature resource GET handler called\n");
-    LOG_DBG("Sending roomTemp: %s°C\n", (char *)buffer);
 }
 
 static void res_event_handler(void)
 {
     update_roomTemp();
-    coap_notify_observers(&res_roomTemp);
+
+    // the target is a boundary only while the conditioner works towards it
+    float distance = ADAPTIVE_SAMPLER_NO_BOUNDARY;
+    if (status == STATUS_COOL || status == STATUS_HEAT)
+        distance = roomTemp > target_temp ? roomTemp - target_temp : target_temp - roomTemp;
+    adaptive_sampler_update(&roomTemp_sampler, roomTemp, distance);
+
+    notify_delivery_notify(&roomTemp_delivery, &res_roomTemp);
     
     LOG_DBG("Room temperature resource event handler called\n");
 }
@@ -3,6 +3,12 @@
 #include <string.h>
 #include "contiki.h"
 #include "coap-engine.h"
+#include "fixed-fmt.h"
+#include "senml-cbor.h"
+#include "notify-policy.h"
+#include "profile.h"
+#include "checkpoint.h"
+#include "../checkpoint-ids.h"
 #include "random.h"
 #include "dev/leds.h"
 
@@ -17,7 +23,6 @@
 // external resources
 enum status_t {STATUS_OFF, STATUS_VENT, STATUS_COOL, STATUS_HEAT, STATUS_ERROR};
 enum cond_mode_t {MODE_NORMAL, MODE_GREEN};
-char* str(float value, char* output);
 void handle_settings(float old_power, enum status_t old_status, enum cond_mode_t old_mode, float old_target_temp);
 
 float conditioner_power = 0.0; // Power of the conditioner in W
@@ -25,39 +30,87 @@ enum status_t status = STATUS_OFF;
 enum cond_mode_t cond_mode = MODE_NORMAL;
 float target_temp = 27.5;
 
+// Kept across reboots, see checkpoint.h. The power on its own, at most
+// once a minute: in green mode it changes at every green step.
+checkpoint_item_t settings_checkpoint = { CKPT_SETTINGS, 2, 0, {
+    { &status, sizeof(status) },
+    { &cond_mode, sizeof(cond_mode) },
+    { &target_temp, sizeof(target_temp) },
+} };
+checkpoint_item_t power_checkpoint = { CKPT_POWER, 1, CLOCK_SECOND * 60, {
+    { &conditioner_power, sizeof(conditioner_power) },
+} };
+
 void settings_json_string(char* buffer)
 {
     // json of settings
-    char buf1[16], buf2[16];
-    int snlen = snprintf(buffer, 
-            COAP_MAX_CHUNK_SIZE,
-            "{\"n\":\"settings\",\"pw\":%s,\"status\":%d,\"mode\":%d,\"targetTemp\":%s}",
-            str(conditioner_power, buf1), status, cond_mode, str(target_temp, buf2));
-    buffer[snlen] = '\0'; // Ensure null termination
+    char *p = fmt_str(buffer, "{\"n\":\"settings\",\"pw\":");
+    p = fmt_fixed(p, conditioner_power, FMT_PRECISION);
+    p = fmt_str(p, ",\"status\":");
+    p = fmt_int(p, status);
+    p = fmt_str(p, ",\"mode\":");
+    p = fmt_int(p, cond_mode);
+    p = fmt_str(p, ",\"targetTemp\":");
+    p = fmt_fixed(p, target_temp, FMT_PRECISION);
+    fmt_str(p, "}");
 }
 
+int settings_senml_cbor(uint8_t* buffer)
+{
+    uint8_t *p = senml_cbor_pack(buffer, 4);
+    p = senml_cbor_record(p, "settings/", "pw", conditioner_power);
+    p = senml_cbor_record(p, NULL, "status", status);
+    p = senml_cbor_record(p, NULL, "mode", cond_mode);
+    p = senml_cbor_record(p, NULL, "targetTemp", target_temp);
+    return p - buffer;
+}
+
+// Notification delivery: state changes, confirmable
+notify_delivery_t settings_delivery = { true };
+extern profile_t profile_json; // serializers, see res-diag.c
+
+// Content format of the notifications, see senml_cbor_select_format()
+static unsigned int notify_format = APPLICATION_JSON;
+
 // RESOURCE definition
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_post_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset);
 static void res_event_handler(void);
 
+// handler latencies, see diag/latency
+LATENCY_HANDLER(settings_get, res_get_handler)
+LATENCY_HANDLER(settings_post, res_post_put_handler)
+LATENCY_EVENT_HANDLER(settings_event, res_event_handler)
+
 EVENT_RESOURCE(res_settings,
                 "title=\"HVAC power, status (off|vent|cool|heat|error), mode (normal|green)\";rt=\"Control\";obs",
-                res_get_handler,
-                res_post_put_handler,
-                res_post_put_handler,
+                res_get_handler_timed,
+                res_post_put_handler_timed,
+                res_post_put_handler_timed,
                 NULL,                
-                res_event_handler);
+                res_event_handler_timed);
 
 static void res_get_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
 {
-    settings_json_string((char *)buffer);
-
-    coap_set_header_content_format(response, APPLICATION_JSON);
-    coap_set_payload(response, buffer, strlen((char *)buffer));
+    if (offset == NULL)
+        notify_delivery_prepare(&settings_delivery, response);
+
+    int format = senml_cbor_select_format(request, offset, &notify_format);
+    if (format == SENML_CBOR_CONTENT_FORMAT) {
+        coap_set_header_content_format(response, SENML_CBOR_CONTENT_FORMAT);
+        coap_set_payload(response, buffer, settings_senml_cbor(buffer));
+    } else if (format == APPLICATION_JSON) {
+        rtimer_clock_t start = profile_start();
+        settings_json_string((char *)buffer);
+        profile_stop(&profile_json, start);
+        coap_set_header_content_format(response, APPLICATION_JSON);
+        coap_set_payload(response, buffer, strlen((char *)buffer));
+        LOG_DBG("Sending settings: %s\n", (char *)buffer);
+    } else {
+        coap_set_status_code(response, NOT_ACCEPTABLE_4_06);
+    }
 
     LOG_DBG("settings resource GET handler called\n");
-    LOG_DBG("Sending settings: %s\n", (char *)buffer);
 }
 
 static void res_post_put_handler(coap_message_t *request, coap_message_t *response, uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
@@ -178,17 +231,20 @@ static void res_post_put_handler(coap_message_t *request, coap_message_t *respon
         leds_single_off(LEDS_YELLOW); // Turn off yellow LED
 #endif
     
-    char power_str[16], target_temp_str[16];
+    char power_str[FMT_FLOAT_BUF_SIZE], target_temp_str[FMT_FLOAT_BUF_SIZE];
     LOG_DBG("Air conditioning updated: power=%s, status=%d, mode=%d, targetTemp=%s\n",
-             str(conditioner_power, power_str), status, cond_mode, str(target_temp, target_temp_str));
+             fmt_float(conditioner_power, power_str), status, cond_mode, fmt_float(target_temp, target_temp_str));
 
     coap_set_status_code(response, CHANGED_2_04);
 
     handle_settings(old_power, old_status, old_mode, old_target_temp);
+    checkpoint_save(&settings_checkpoint);
+    checkpoint_save(&power_checkpoint);
 }
 
 static void res_event_handler(void)
 {
-    coap_notify_observers(&res_settings);
+    checkpoint_save(&power_checkpoint); // green mode power
+    notify_delivery_notify(&settings_delivery, &res_settings);
     LOG_DBG("settings resource event handler called\n");
 }